@@ -1,6 +1,23 @@
 #!/bin/bash
 
-FILES="src/main.c"
+# the simulation (and the bots) don't depend on raylib so it can be shared with the headless tools
+SIM_FILES="src/panel.c src/replay.c src/bot.c src/eval.c src/mcts.c src/panel_batch.c src/threadpool.c src/ttable.c src/puzzle.c src/puzzle_solver.c src/env.c src/trajectory.c src/ccfuncs.c"
 RAYLIB="-I./raylib-5.5/include -L./raylib-5.5/lib/ -l:libraylib.a"
 
-gcc -Wall -Werror $FILES -o main $RAYLIB -lm
+# extra flags can be passed from the environment, e.g. CFLAGS=-O3 ./build.sh
+gcc -Wall -Werror $CFLAGS src/main.c src/render.c src/render_list.c src/triple_buffer.c src/input_queue.c src/keyboard.c src/latency.c src/pacer.c $SIM_FILES -o main $RAYLIB -lm -pthread
+
+gcc -Wall -Werror $CFLAGS src/desync.c $SIM_FILES -o desync -lm -pthread
+gcc -Wall -Werror $CFLAGS src/bench.c $SIM_FILES -o bench -lm -pthread
+gcc -Wall -Werror $CFLAGS src/solve.c $SIM_FILES -o solve -lm -pthread
+gcc -Wall -Werror $CFLAGS src/genpuzzles.c $SIM_FILES -o genpuzzles -lm -pthread
+gcc -Wall -Werror $CFLAGS src/tune.c $SIM_FILES -o tune -lm -pthread
+gcc -Wall -Werror $CFLAGS src/tournament.c $SIM_FILES -o tournament -lm -pthread
+# draws without a GPU, only the CPU side of raylib (images) is used
+gcc -Wall -Werror $CFLAGS src/rasterize.c src/raster.c src/render_list.c $SIM_FILES -o rasterize $RAYLIB -lm -pthread
+gcc -Wall -Werror $CFLAGS src/video.c src/raster.c src/render_list.c $SIM_FILES -o video $RAYLIB -lm -pthread
+gcc -Wall -Werror $CFLAGS src/shmbridge.c src/bridge.c $SIM_FILES -o shmbridge -lm -pthread
+
+# the env API for training, only the functions marked with ENV_API are exported
+ENV_FILES="src/env.c src/panel.c src/panel_batch.c src/threadpool.c src/ccfuncs.c"
+gcc -Wall -Werror $CFLAGS -shared -fPIC -fvisibility=hidden $ENV_FILES -o libtetrisattack.so -lm -pthread
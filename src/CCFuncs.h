@@ -53,6 +53,7 @@
 
 // printf like function that prints the name and line of the file where it was called
 #define log_error(msg, ...) _log_error(msg, __FILE__, __LINE__, __VA_ARGS__);
+void _log_error(const char *msg, char *file, int line, ...);
 
 // STRING BUILDER //
 
@@ -0,0 +1,334 @@
+// bench: measures the simulation throughput under realistic play
+//
+// a bot plays a panel headless as fast as it can and the throughput of the
+// game itself and of the simulation done by the bot's search is reported
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bot.h"
+#include "env.h"
+#include "eval.h"
+#include "mcts.h"
+#include "panel_batch.h"
+#include "panel.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+#define BENCH_DEFAULT_TICKS 3600
+// there are no new blocks so a game is over once the bot can't clear anything
+// else, after this many ticks without clearing a new game is started
+#define BENCH_STALL_TICKS 300
+
+// plays random swaps on PANEL_BATCH_LANES panels, first one by one with panel_update
+// and then all together with panel_batch_update, checking both give the same game
+int bench_batch(size_t ticks, uint64_t seed) {
+    Panel panels[PANEL_BATCH_LANES];
+    PanelBatch batch;
+    // the swaps of every tick and lane are decided before so both runs do the same ones
+    int *swaps = malloc(sizeof(int) * ticks * PANEL_BATCH_LANES);
+
+    for(int lane = 0; lane < PANEL_BATCH_LANES; lane++) {
+        panels[lane] = (Panel){0};
+        panel_init(&panels[lane], seed + lane);
+        panel_batch_load(&batch, lane, &panels[lane]);
+    }
+
+    uint64_t rng = seed;
+    double start = now_seconds();
+
+    for(size_t tick = 0; tick < ticks; tick++) {
+        for(int lane = 0; lane < PANEL_BATCH_LANES; lane++) {
+            Panel *panel = &panels[lane];
+            uint64_t legal = panel_legal_swaps(panel);
+            uint64_t r = splitmix64_next(&rng);
+
+            // a swap every 4 ticks more or less, like the bots do
+            int swap = -1;
+            if(legal != 0 && r % 4 == 0) {
+                int n = (r >> 8) % __builtin_popcountll(legal);
+                while(n-- > 0) legal &= legal - 1;
+                swap = __builtin_ctzll(legal);
+                panel_swap(panel, swap / PANEL_SWAPS_PER_ROW, swap % PANEL_SWAPS_PER_ROW);
+            }
+            swaps[tick * PANEL_BATCH_LANES + lane] = swap;
+
+            panel_update(panel);
+        }
+    }
+
+    double scalarTime = now_seconds() - start;
+    start = now_seconds();
+
+    for(size_t tick = 0; tick < ticks; tick++) {
+        for(int lane = 0; lane < PANEL_BATCH_LANES; lane++) {
+            int swap = swaps[tick * PANEL_BATCH_LANES + lane];
+            if(swap >= 0) panel_batch_swap(&batch, lane, swap / PANEL_SWAPS_PER_ROW, swap % PANEL_SWAPS_PER_ROW);
+        }
+
+        panel_batch_update(&batch);
+    }
+
+    double batchTime = now_seconds() - start;
+    free(swaps);
+
+    int mismatches = 0;
+    uint32_t clearedBlocks = 0;
+    for(int lane = 0; lane < PANEL_BATCH_LANES; lane++) {
+        if(!panel_batch_matches(&batch, lane, &panels[lane])) mismatches++;
+        clearedBlocks += panels[lane].clearedBlocks;
+    }
+
+    double panelTicks = (double)ticks * PANEL_BATCH_LANES;
+    printf("%d panels, %zu ticks each, %u blocks cleared\n", PANEL_BATCH_LANES, ticks, clearedBlocks);
+    printf("  panel_update:       %.0f panel ticks/s\n", panelTicks / scalarTime);
+    printf("  panel_batch_update: %.0f panel ticks/s (%.1fx)\n", panelTicks / batchTime, scalarTime / batchTime);
+
+    if(mismatches > 0) {
+        printf("  %d panels ended different from panel_update\n", mismatches);
+        return 1;
+    }
+
+    printf("  every panel ended the same as with panel_update\n");
+    return 0;
+}
+
+// steps the env API with random actions, the way a training loop would use it
+int bench_env(int numEnvs, size_t ticks, uint64_t seed, int threads) {
+    Env *env = env_create(numEnvs, seed, BENCH_DEFAULT_TICKS, threads);
+    uint8_t *observations = malloc((size_t)numEnvs * ENV_OBSERVATION_SIZE);
+    uint8_t *actions = malloc(numEnvs);
+    float *rewards = malloc(sizeof(float) * numEnvs);
+    uint8_t *dones = malloc(numEnvs);
+    assert(observations != NULL && actions != NULL && rewards != NULL && dones != NULL && "Not enough memory");
+
+    env_reset(env, observations);
+
+    uint64_t rng = seed;
+    double reward = 0;
+    double elapsed = 0;
+
+    for(size_t tick = 0; tick < ticks; tick++) {
+        // a random key (or none) every tick
+        for(int i = 0; i < numEnvs; i++) {
+            actions[i] = 1 << (splitmix64_next(&rng) % 8) & 0x1f;
+        }
+
+        double start = now_seconds();
+        env_step_batch(env, actions, observations, rewards, dones);
+        elapsed += now_seconds() - start;
+
+        for(int i = 0; i < numEnvs; i++) reward += rewards[i];
+    }
+
+    printf("env with %d panels, %zu steps in %.3fs\n", numEnvs, ticks, elapsed);
+    printf("  panel steps/s:  %.0f\n", (double)numEnvs * ticks / elapsed);
+    printf("  blocks cleared: %.0f\n", reward);
+
+    env_destroy(env);
+    free(observations);
+    free(actions);
+    free(rewards);
+    free(dones);
+    return 0;
+}
+
+// boards of random games packed once and then scored again and again, the
+// packing is measured apart since the search packs every board it scores.
+// The search packs the board it just simulated so the panels are few enough
+// to stay in the cache
+#define BENCH_EVAL_BOARDS 64
+#define BENCH_EVAL_ROUNDS 100000
+
+int bench_eval(uint64_t seed, const EvalWeights *weights) {
+    Panel *panels = malloc(sizeof(Panel) * BENCH_EVAL_BOARDS);
+    EvalBoard *boards = malloc(sizeof(EvalBoard) * BENCH_EVAL_BOARDS);
+    assert(panels != NULL && boards != NULL && "Not enough memory");
+
+    uint64_t rng = seed;
+    Panel panel = {0};
+    panel_init(&panel, seed);
+
+    for(int i = 0; i < BENCH_EVAL_BOARDS; i++) {
+        // a few random keys between the boards kept
+        for(int tick = 0; tick < 16; tick++) {
+            panel_apply_input(&panel, 1 << (splitmix64_next(&rng) % 8) & 0x1f);
+            panel_update(&panel);
+        }
+        panels[i] = panel;
+    }
+
+    double start = now_seconds();
+    for(int round = 0; round < BENCH_EVAL_ROUNDS / 10; round++) {
+        for(int i = 0; i < BENCH_EVAL_BOARDS; i++) eval_pack(&boards[i], &panels[i]);
+    }
+    double packTime = now_seconds() - start;
+
+    // the sum keeps the compiler from dropping the calls
+    double sum = 0;
+    start = now_seconds();
+    for(int round = 0; round < BENCH_EVAL_ROUNDS; round++) {
+        for(int i = 0; i < BENCH_EVAL_BOARDS; i++) sum += eval_score(weights, &boards[i]);
+    }
+    double scoreTime = now_seconds() - start;
+
+    double packed = (double)BENCH_EVAL_BOARDS * BENCH_EVAL_ROUNDS / 10;
+    double scored = (double)BENCH_EVAL_BOARDS * BENCH_EVAL_ROUNDS;
+    printf("evaluator, %d boards (checksum %.0f)\n", BENCH_EVAL_BOARDS, sum / BENCH_EVAL_ROUNDS);
+    printf("  eval_pack:   %.0f boards/s\n", packed / packTime);
+    printf("  eval_score:  %.0f boards/s\n", scored / scoreTime);
+    printf("  both:        %.0f boards/s\n", 1 / (packTime / packed + scoreTime / scored));
+
+    free(panels);
+    free(boards);
+    return 0;
+}
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --bot <beam|mcts>  bot that plays (default beam)\n");
+    printf("  --ticks <n>        game ticks to play (default %d)\n", BENCH_DEFAULT_TICKS);
+    printf("  --seed <n>         seed of the panel\n");
+    printf("  --width <n>        beam width\n");
+    printf("  --depth <n>        swaps searched ahead by the beam bot\n");
+    printf("  --threads <n>      workers of the mcts bot and the env (default every core)\n");
+    printf("  --playouts <n>     playouts of every mcts search\n");
+    printf("  --ttable <kb>      transposition table of the beam bot, 0 disables it\n");
+    printf("  --weights <file>   weights of the beam bot's evaluation\n");
+    printf("  --batch            compares panel_update with panel_batch_update instead of playing\n");
+    printf("  --env <n>          steps n panels with the env API and random actions instead of playing\n");
+    printf("  --eval             measures the board evaluation instead of playing\n");
+}
+
+int main(int argc, char **argv) {
+    size_t ticks = BENCH_DEFAULT_TICKS;
+    uint64_t seed = 1;
+    bool useMcts = false;
+    bool batch = false;
+    bool eval = false;
+    int envPanels = 0;
+    BeamBotConfig beamConfig = BEAM_BOT_DEFAULT_CONFIG;
+    MctsBotConfig mctsConfig = MCTS_BOT_DEFAULT_CONFIG;
+    // the whole search runs every time so the results can be compared between runs
+    beamConfig.timeBudget = 0;
+    mctsConfig.timeBudget = 0;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--bot") == 0 && hasValue) {
+            useMcts = strcmp(argv[++i], "mcts") == 0;
+        } else if(strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            ticks = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--width") == 0 && hasValue) {
+            beamConfig.beamWidth = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--depth") == 0 && hasValue) {
+            beamConfig.depth = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--threads") == 0 && hasValue) {
+            mctsConfig.threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--playouts") == 0 && hasValue) {
+            mctsConfig.maxPlayouts = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--ttable") == 0 && hasValue) {
+            beamConfig.ttableBytes = strtoull(argv[++i], NULL, 10) * 1024;
+        } else if(strcmp(argv[i], "--weights") == 0 && hasValue) {
+            if(!eval_weights_load(&beamConfig.weights, argv[++i])) return 1;
+        } else if(strcmp(argv[i], "--env") == 0 && hasValue) {
+            envPanels = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--batch") == 0) {
+            batch = true;
+        } else if(strcmp(argv[i], "--eval") == 0) {
+            eval = true;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    zobrist_init();
+
+    if(batch) return bench_batch(ticks, seed);
+    if(eval) return bench_eval(seed, &beamConfig.weights);
+    if(envPanels > 0) return bench_env(envPanels, ticks, seed, mctsConfig.threads);
+
+    Panel panel = {0};
+    panel_init(&panel, seed);
+
+    BeamBot beamBot;
+    MctsBot mctsBot;
+    if(useMcts) {
+        mctsConfig.seed = seed;
+        mcts_bot_init(&mctsBot, mctsConfig);
+    } else {
+        beam_bot_init(&beamBot, beamConfig);
+    }
+
+    double start = now_seconds();
+    size_t games = 1;
+    uint32_t clearedBlocks = 0;
+    size_t lastClearTick = 0;
+
+    for(size_t tick = 0; tick < ticks; tick++) {
+        uint32_t cleared = panel.clearedBlocks;
+
+        uint8_t input = useMcts ? mcts_bot_input(&mctsBot, &panel) : beam_bot_input(&beamBot, &panel);
+        panel_apply_input(&panel, input);
+        panel_update(&panel);
+
+        if(panel.clearedBlocks != cleared || panel.combos.count > 0) lastClearTick = tick;
+
+        if(tick - lastClearTick >= BENCH_STALL_TICKS) {
+            clearedBlocks += panel.clearedBlocks;
+            panel = (Panel){0};
+            panel_init(&panel, seed + games);
+            games++;
+            lastClearTick = tick;
+        }
+    }
+
+    clearedBlocks += panel.clearedBlocks;
+
+    double elapsed = now_seconds() - start;
+
+    if(useMcts) {
+        MctsStats *stats = &mctsBot.stats;
+        int workers = mctsBot.pool->numWorkers;
+
+        printf("mcts bot (%d workers, %d playouts), %zu ticks in %.3fs\n", workers, mctsConfig.maxPlayouts, ticks, elapsed);
+        printf("  game ticks/s:        %.0f (%.1fx real time)\n", ticks / elapsed, ticks / elapsed / PANEL_TICKS_PER_SECOND);
+        printf("  searches:            %llu\n", (unsigned long long)stats->searches);
+        printf("  playouts/s:          %.0f\n", stats->playouts / stats->searchTime);
+        // per core uses the wall time so idle workers lower it, busy shows how much they worked
+        printf("  playouts/s per core: %.0f (workers busy %.0f%% of the time)\n",
+            stats->playouts / stats->searchTime / workers,
+            100 * stats->workerTime / (stats->searchTime * workers));
+        printf("  simulated ticks/s:   %.0f\n", stats->simulatedTicks / stats->searchTime);
+        printf("  games:               %zu\n", games);
+        printf("  cleared blocks:      %u\n", clearedBlocks);
+        mcts_bot_free(&mctsBot);
+    } else {
+        BotStats *stats = &beamBot.stats;
+
+        printf("beam bot (width %d, depth %d), %zu ticks in %.3fs\n", beamConfig.beamWidth, beamConfig.depth, ticks, elapsed);
+        printf("  game ticks/s:      %.0f (%.1fx real time)\n", ticks / elapsed, ticks / elapsed / PANEL_TICKS_PER_SECOND);
+        printf("  searches:          %llu\n", (unsigned long long)stats->searches);
+        printf("  nodes/s:           %.0f\n", stats->nodes / stats->searchTime);
+        printf("  simulated ticks/s: %.0f\n", stats->simulatedTicks / stats->searchTime);
+        printf("  transpositions:    %llu (%.1f%% of the nodes)\n", (unsigned long long)stats->transpositions,
+            100.0 * stats->transpositions / stats->nodes);
+
+        TTableStats tt;
+        ttable_stats(&beamBot.ttable, &tt);
+        if(tt.probes > 0) {
+            printf("  ttable (%zu KB):    %.1f%% hits, %llu stores, %llu evictions, %llu rejected\n",
+                beamConfig.ttableBytes / 1024, 100.0 * tt.hits / tt.probes, (unsigned long long)tt.stores,
+                (unsigned long long)tt.evictions, (unsigned long long)tt.rejected);
+        }
+        printf("  games:             %zu\n", games);
+        printf("  cleared blocks:    %u\n", clearedBlocks);
+        beam_bot_free(&beamBot);
+    }
+
+    return 0;
+}
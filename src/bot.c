@@ -0,0 +1,214 @@
+#include "bot.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+void beam_bot_init(BeamBot *bot, BeamBotConfig config) {
+    *bot = (BeamBot){0};
+    bot->config = config;
+    bot->target = -1;
+
+    // the children of a level only keep the best beamWidth, a worse one is dropped
+    // as soon as it's made so neither level grows past the width
+    bot->beam = malloc(sizeof(BeamNode) * config.beamWidth);
+    bot->next = malloc(sizeof(BeamNode) * config.beamWidth);
+    assert(bot->beam != NULL && bot->next != NULL && "Not enough memory");
+
+    ttable_init(&bot->ttable, config.ttableBytes);
+}
+
+void beam_bot_free(BeamBot *bot) {
+    free(bot->beam);
+    free(bot->next);
+    ttable_free(&bot->ttable);
+}
+
+float bot_evaluate(const EvalWeights *weights, Panel *panel) {
+    EvalBoard board;
+    eval_pack(&board, panel);
+    return eval_score(weights, &board);
+}
+
+uint64_t bot_board_key(Panel *panel) {
+    // one bit per cell, there are more than 64 cells so the last ones go to the second word
+    uint64_t inCombo[2] = {0};
+    uint64_t falling[2] = {0};
+
+    for(int cell = 0; cell < PANEL_NUM_OF_CELLS; cell++) {
+        PanelBlock *block = &panel->blocks[cell / PANEL_NUM_OF_COLS][cell % PANEL_NUM_OF_COLS];
+        if(block->inCombo) inCombo[cell / 64] |= (uint64_t)1 << (cell % 64);
+        if(block->falling) falling[cell / 64] |= (uint64_t)1 << (cell % 64);
+    }
+
+    // splitmix64 spreads the masks over every bit, every word has its own seed
+    // so the same mask on two of them doesn't cancel out
+    uint64_t key = panel->hash;
+    uint64_t words[] = { inCombo[0], inCombo[1], falling[0], falling[1] };
+    for(size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        uint64_t state = words[i] ^ (ZOBRIST_SEED * (i + 1));
+        key ^= splitmix64_next(&state);
+    }
+
+    return key;
+}
+
+int bot_simulate_swap(Panel *panel, int swap, int maxTicks) {
+    panel_swap(panel, swap / PANEL_SWAPS_PER_ROW, swap % PANEL_SWAPS_PER_ROW);
+
+    int ticks = 0;
+    do {
+        panel_update(panel);
+        ticks++;
+    } while(ticks < maxTicks && panel_has_falling_blocks(panel));
+
+    return ticks;
+}
+
+// adds the node to the next beam if it's better than the worst one there
+static void push_next(BeamBot *bot, BeamNode *node) {
+    if(bot->nextCount < bot->config.beamWidth) {
+        bot->next[bot->nextCount++] = *node;
+        return;
+    }
+
+    int worst = 0;
+    for(int i = 1; i < bot->nextCount; i++) {
+        if(bot->next[i].score < bot->next[worst].score) worst = i;
+    }
+
+    if(node->score > bot->next[worst].score) bot->next[worst] = *node;
+}
+
+static void start_search(BeamBot *bot, Panel *panel) {
+    bot->searching = true;
+    bot->depth = 0;
+    bot->beam[0] = (BeamNode){ .panel = *panel, .score = bot_evaluate(&bot->config.weights, panel), .firstSwap = -1 };
+    bot->beamCount = 1;
+    bot->nextCount = 0;
+    bot->expanded = 0;
+    bot->pendingSwaps = panel_legal_swaps(panel);
+    bot->rootScore = bot->beam[0].score;
+
+    // the root is a transposition too, swapping a pair and then swapping it back
+    ttable_new_search(&bot->ttable);
+    ttable_store(&bot->ttable, bot_board_key(panel), bot->rootScore, bot->config.depth);
+}
+
+// scores the child using the transposition table, returns false if the same board was
+// already reached in this search with at least as many swaps left so it can be skipped
+static bool score_child(BeamBot *bot, BeamNode *child) {
+    uint64_t key = bot_board_key(&child->panel);
+    // swaps that can still be done after this one
+    int depth = bot->config.depth - bot->depth - 1;
+    TTableHit hit;
+
+    if(ttable_probe(&bot->ttable, key, &hit)) {
+        if(hit.currentSearch && hit.depth >= depth) {
+            bot->stats.transpositions++;
+            return false;
+        }
+        child->score = hit.score;
+    } else {
+        child->score = bot_evaluate(&bot->config.weights, &child->panel);
+    }
+
+    ttable_store(&bot->ttable, key, child->score, depth);
+    return true;
+}
+
+static void finish_search(BeamBot *bot) {
+    bot->searching = false;
+    bot->stats.searches++;
+
+    // the beam is never sorted so the best node has to be looked up,
+    // a line of play is only worth it if it improves the current board
+    int best = -1;
+    float bestScore = bot->rootScore;
+    for(int i = 0; i < bot->beamCount; i++) {
+        if(bot->beam[i].firstSwap < 0) continue;
+        if(bot->beam[i].score > bestScore) {
+            best = i;
+            bestScore = bot->beam[i].score;
+        }
+    }
+
+    bot->target = best < 0 ? -1 : bot->beam[best].firstSwap;
+}
+
+// returns true when the search is done
+static bool search(BeamBot *bot) {
+    double start = now_seconds();
+    double budget = bot->config.timeBudget;
+
+    while(bot->depth < bot->config.depth) {
+        while(bot->expanded < bot->beamCount) {
+            BeamNode *node = &bot->beam[bot->expanded];
+
+            while(bot->pendingSwaps != 0) {
+                int swap = __builtin_ctzll(bot->pendingSwaps);
+                bot->pendingSwaps &= bot->pendingSwaps - 1;
+
+                BeamNode child = *node;
+                if(child.firstSwap < 0) child.firstSwap = swap;
+
+                bot->stats.simulatedTicks += bot_simulate_swap(&child.panel, swap, bot->config.settleTicks);
+                bot->stats.nodes++;
+                if(score_child(bot, &child)) push_next(bot, &child);
+
+                if(budget > 0 && now_seconds() - start >= budget) {
+                    bot->stats.searchTime += now_seconds() - start;
+                    return false;
+                }
+            }
+
+            bot->expanded++;
+            if(bot->expanded < bot->beamCount) {
+                bot->pendingSwaps = panel_legal_swaps(&bot->beam[bot->expanded].panel);
+            }
+        }
+
+        // no node had legal swaps, the current beam is as deep as it gets
+        if(bot->nextCount == 0) break;
+
+        BeamNode *temp = bot->beam;
+        bot->beam = bot->next;
+        bot->next = temp;
+        bot->beamCount = bot->nextCount;
+        bot->nextCount = 0;
+        bot->expanded = 0;
+        bot->pendingSwaps = panel_legal_swaps(&bot->beam[0].panel);
+        bot->depth++;
+    }
+
+    bot->stats.searchTime += now_seconds() - start;
+    finish_search(bot);
+    return true;
+}
+
+uint8_t bot_walk_to_swap(Panel *panel, int *target) {
+    int row = *target / PANEL_SWAPS_PER_ROW;
+    int col = *target % PANEL_SWAPS_PER_ROW;
+    uint8_t input = 0;
+
+    if(panel->cursor.x < col) input |= PANEL_INPUT_RIGHT;
+    if(panel->cursor.x > col) input |= PANEL_INPUT_LEFT;
+    if(panel->cursor.y < row) input |= PANEL_INPUT_DOWN;
+    if(panel->cursor.y > row) input |= PANEL_INPUT_UP;
+
+    if(input == 0) {
+        // the board kept moving while the bot searched and walked there, so the
+        // swap may not make sense anymore
+        if(panel_legal_swaps(panel) & PANEL_SWAP_BIT(row, col)) input |= PANEL_INPUT_SWAP;
+        *target = -1;
+    }
+
+    return input;
+}
+
+uint8_t beam_bot_input(BeamBot *bot, Panel *panel) {
+    if(bot->target < 0) {
+        if(!bot->searching) start_search(bot, panel);
+        if(!search(bot) || bot->target < 0) return 0;
+    }
+
+    return bot_walk_to_swap(panel, &bot->target);
+}
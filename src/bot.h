@@ -0,0 +1,83 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "eval.h"
+#include "panel.h"
+#include "ttable.h"
+
+typedef struct {
+    int beamWidth;     // states kept on every depth of the search
+    int depth;         // swaps planned ahead
+    int settleTicks;   // max ticks simulated after a swap waiting for the blocks to land
+    // seconds the search can take on every call, the search continues on the next
+    // call when it runs out. 0 means the search always finishes (deterministic)
+    double timeBudget;
+    size_t ttableBytes; // size of the transposition table, 0 disables it
+    EvalWeights weights; // of the features bot_evaluate scores the boards with
+} BeamBotConfig;
+
+#define BEAM_BOT_DEFAULT_CONFIG ((BeamBotConfig){ \
+    .beamWidth = 8,                              \
+    .depth = 2,                                  \
+    .settleTicks = 24,                           \
+    .timeBudget = 0.004,                         \
+    .ttableBytes = 1 << 20,                      \
+    .weights = EVAL_DEFAULT_WEIGHTS,             \
+})
+
+typedef struct {
+    uint64_t searches;       // finished searches, one per decision
+    uint64_t nodes;          // evaluated states
+    uint64_t transpositions; // states skipped since another order of swaps reached them first
+    uint64_t simulatedTicks; // panel_update calls made by the search
+    double searchTime;       // seconds spent searching
+} BotStats;
+
+typedef struct {
+    Panel panel;
+    float score;
+    int firstSwap; // the swap that started this line of play (row * PANEL_SWAPS_PER_ROW + col)
+} BeamNode;
+
+typedef struct {
+    BeamBotConfig config;
+    BotStats stats;
+    // boards already scored, by this search or the previous ones
+    TTable ttable;
+
+    // the swap the bot is moving the cursor to, -1 while it's searching
+    int target;
+
+    // the search state, kept between calls so it can be spread across frames
+    bool searching;
+    float rootScore; // the score of the board when the search started
+    int depth;
+    BeamNode *beam;
+    int beamCount;
+    BeamNode *next;
+    int nextCount;
+    int expanded;          // nodes of the beam already expanded
+    uint64_t pendingSwaps; // swaps of the node being expanded that weren't tried yet
+} BeamBot;
+
+void beam_bot_init(BeamBot *bot, BeamBotConfig config);
+void beam_bot_free(BeamBot *bot);
+
+// returns the PanelInput flags the bot wants to press this tick, it goes through
+// the same path as the keyboard so the bot can't do anything a player can't
+uint8_t beam_bot_input(BeamBot *bot, Panel *panel);
+
+// the score the bot gives to a board with the given weights, higher is better
+float bot_evaluate(const EvalWeights *weights, Panel *panel);
+// hash of everything bot_evaluate and the legal swaps depend on: the zobrist hash
+// plus which blocks are in a combo or falling (the combos' timers aren't included)
+uint64_t bot_board_key(Panel *panel);
+
+// swaps and simulates until the blocks land (or maxTicks pass), returns the ticks simulated
+int bot_simulate_swap(Panel *panel, int swap, int maxTicks);
+
+// returns the input that moves the cursor one step closer to the target swap,
+// once it's there the swap is done (if it's still legal) and target is set to -1
+uint8_t bot_walk_to_swap(Panel *panel, int *target);
+
+#endif // BOT_H
@@ -0,0 +1,144 @@
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bridge.h"
+#include "CCFuncs.h"
+
+// checks of the counter before sleeping, a step of the other process is usually
+// shorter than going to sleep and being woken up
+#define BRIDGE_SPINS 4096
+// the longest sleep on the futex, so a process that only polls and never calls
+// FUTEX_WAKE (easier from some languages) still gets answered
+#define BRIDGE_SLEEP_NS 1000000
+
+static uint64_t align_up(uint64_t value, uint64_t align) {
+    return (value + align - 1) / align * align;
+}
+
+void bridge_layout(BridgeHeader *header, uint32_t numEnvs, uint32_t slots) {
+    *header = (BridgeHeader){
+        .magic = BRIDGE_MAGIC,
+        .version = BRIDGE_VERSION,
+        .numEnvs = numEnvs,
+        .slots = slots,
+        .observationSize = BRIDGE_OBSERVATION_SIZE,
+    };
+
+    header->actionSlotSize = align_up(numEnvs, BRIDGE_SLOT_ALIGN);
+
+    uint32_t observations = numEnvs * BRIDGE_OBSERVATION_SIZE;
+    header->rewardsOffset = align_up(observations, sizeof(float));
+    header->donesOffset = header->rewardsOffset + numEnvs * sizeof(float);
+    header->observationSlotSize = align_up(header->donesOffset + numEnvs, BRIDGE_SLOT_ALIGN);
+
+    header->actionsOffset = BRIDGE_HEADER_SIZE;
+    header->observationsOffset = header->actionsOffset + (uint64_t)slots * header->actionSlotSize;
+    header->fileSize = header->observationsOffset + (uint64_t)slots * header->observationSlotSize;
+}
+
+uint8_t *bridge_actions(BridgeHeader *header, uint32_t step) {
+    return (uint8_t *)header + header->actionsOffset + (uint64_t)(step % header->slots) * header->actionSlotSize;
+}
+
+uint8_t *bridge_observations(BridgeHeader *header, uint32_t step) {
+    return (uint8_t *)header + header->observationsOffset + (uint64_t)(step % header->slots) * header->observationSlotSize;
+}
+
+float *bridge_rewards(BridgeHeader *header, uint32_t step) {
+    return (float *)(bridge_observations(header, step) + header->rewardsOffset);
+}
+
+uint8_t *bridge_dones(BridgeHeader *header, uint32_t step) {
+    return bridge_observations(header, step) + header->donesOffset;
+}
+
+uint32_t bridge_wait(BridgeHeader *header, atomic_uint *counter, uint32_t value) {
+    for(int i = 0; i < BRIDGE_SPINS; i++) {
+        uint32_t current = atomic_load_explicit(counter, memory_order_acquire);
+        if(current != value || atomic_load_explicit(&header->closed, memory_order_relaxed)) return current;
+    }
+
+    while(true) {
+        uint32_t current = atomic_load_explicit(counter, memory_order_acquire);
+        if(current != value || atomic_load_explicit(&header->closed, memory_order_relaxed)) return current;
+
+        // only sleeps if the counter still has the value, so a wake can't be missed
+        struct timespec timeout = { .tv_sec = 0, .tv_nsec = BRIDGE_SLEEP_NS };
+        syscall(SYS_futex, (uint32_t *)counter, FUTEX_WAIT, value, &timeout, NULL, 0);
+    }
+}
+
+void bridge_publish(atomic_uint *counter, uint32_t value) {
+    // release so the slot written before is visible to the other process
+    atomic_store_explicit(counter, value, memory_order_release);
+    syscall(SYS_futex, (uint32_t *)counter, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+static BridgeHeader *map_file(int fd, size_t size, const char *path) {
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED) {
+        log_error("Couldn't map \"%s\"", path);
+        return NULL;
+    }
+    return data;
+}
+
+BridgeHeader *bridge_create(const char *path, uint32_t numEnvs, uint32_t slots) {
+    BridgeHeader layout;
+    bridge_layout(&layout, numEnvs, slots);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0 || ftruncate(fd, layout.fileSize) != 0) {
+        log_error("Couldn't create \"%s\"", path);
+        if(fd >= 0) close(fd);
+        return NULL;
+    }
+
+    BridgeHeader *header = map_file(fd, layout.fileSize, path);
+    if(header == NULL) return NULL;
+
+    // the magic is written last so an agent that opens the file early sees it isn't ready
+    layout.magic = 0;
+    *header = layout;
+    atomic_thread_fence(memory_order_release);
+    header->magic = BRIDGE_MAGIC;
+    return header;
+}
+
+BridgeHeader *bridge_open(const char *path) {
+    int fd = open(path, O_RDWR);
+    if(fd < 0) {
+        log_error("Couldn't open \"%s\"", path);
+        return NULL;
+    }
+
+    BridgeHeader *header = map_file(fd, BRIDGE_HEADER_SIZE, path);
+    if(header == NULL) return NULL;
+
+    if(header->magic != BRIDGE_MAGIC || header->version != BRIDGE_VERSION) {
+        log_error("\"%s\" is not a bridge of version %d", path, BRIDGE_VERSION);
+        munmap(header, BRIDGE_HEADER_SIZE);
+        return NULL;
+    }
+
+    // now the whole file is mapped
+    uint64_t size = header->fileSize;
+    munmap(header, BRIDGE_HEADER_SIZE);
+
+    fd = open(path, O_RDWR);
+    if(fd < 0) {
+        log_error("Couldn't open \"%s\"", path);
+        return NULL;
+    }
+    return map_file(fd, size, path);
+}
+
+void bridge_close(BridgeHeader *header) {
+    munmap(header, header->fileSize);
+}
@@ -0,0 +1,102 @@
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+// the shared memory bridge: an agent in another process (in any language) drives
+// many headless panels through a file mapped by both processes, usually in /dev/shm.
+// Nothing is serialized or copied, the simulation writes the observations straight
+// into the mapping and reads the actions from it.
+//
+// THE FORMAT IS STABLE, everything below is part of it. A change needs a new
+// BRIDGE_VERSION. All the numbers are in the byte order of the machine (both
+// processes run on it) and every offset is from the start of the file.
+//
+// the file starts with a BridgeHeader (BRIDGE_HEADER_SIZE bytes) followed by two rings
+// of "slots" entries each:
+//
+//   actions at actionsOffset, every slot is actionSlotSize bytes:
+//     [0, numEnvs)  the action of every panel, the PanelInput flags of a tick:
+//                   1 left, 2 right, 4 up, 8 down, 16 swap
+//
+//   observations at observationsOffset, every slot is observationSlotSize bytes:
+//     [0, numEnvs * BRIDGE_OBSERVATION_SIZE)  the observation of every panel
+//     rewardsOffset: float32 per panel, the blocks cleared in the step
+//     donesOffset:   uint8 per panel, 1 when the episode ended. The observation
+//                    is then the first one of the next episode
+//
+// the observation of a panel is BRIDGE_OBSERVATION_SIZE bytes:
+//     [0, 72)  a byte per cell, row by row from the top (6 cells per row): the
+//              block type in the low 3 bits (0 empty, 1 yellow, 2 red, 3 purple,
+//              4 green, 5 blue, 6 dark blue), 0x08 in a combo, 0x10 falling
+//     72       cursor column, the left block of the swap (0 to 4)
+//     73       cursor row (0 to 11)
+//
+// the protocol uses two counters, each one written by a single process:
+//   - stepsRequested (agent): the action sets written. Action set i is in the
+//     action slot i % slots and it must be written before the counter is increased
+//   - stepsDone (simulation): the observation sets written. Set 0 is the first
+//     observation after the simulation starts, set j > 0 is the result of the
+//     action set j - 1. Set j is in the observation slot j % slots.
+// Observation set j is overwritten by set j + slots, so it stays valid until the
+// agent submits the action set j + slots - 1. An agent that reads every observation
+// before submitting the next action can use any number of slots.
+//
+// after changing a counter the process wakes the other with FUTEX_WAKE on it (the
+// futex is shared between processes so FUTEX_PRIVATE_FLAG can't be used). A process
+// that has nothing to do waits with FUTEX_WAIT on the counter of the other process.
+// The simulation never sleeps more than 1ms, so an agent that can't call futex can
+// just write the counter and poll stepsDone (with more latency).
+// The agent sets "closed" (and wakes stepsRequested) to stop the simulation.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BRIDGE_MAGIC 0x52424154 // "TABR" in little endian
+#define BRIDGE_VERSION 1
+#define BRIDGE_HEADER_SIZE 256
+#define BRIDGE_OBSERVATION_SIZE 74
+// the slots start on their own cache line
+#define BRIDGE_SLOT_ALIGN 64
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numEnvs;
+    uint32_t slots;
+    uint32_t observationSize; // BRIDGE_OBSERVATION_SIZE
+    uint32_t actionSlotSize;
+    uint32_t observationSlotSize;
+    uint32_t rewardsOffset; // from the start of an observation slot
+    uint32_t donesOffset;   // from the start of an observation slot
+    uint32_t padding;
+    uint64_t actionsOffset;
+    uint64_t observationsOffset;
+    uint64_t fileSize;
+
+    // every counter is on its own cache line so the processes don't fight over them
+    _Alignas(64) atomic_uint stepsRequested;
+    _Alignas(64) atomic_uint stepsDone;
+    _Alignas(64) atomic_uint closed;
+} BridgeHeader;
+
+_Static_assert(sizeof(BridgeHeader) == BRIDGE_HEADER_SIZE, "The bridge header must keep its size");
+
+// fills the header with the layout for the given panels and slots
+void bridge_layout(BridgeHeader *header, uint32_t numEnvs, uint32_t slots);
+
+uint8_t *bridge_actions(BridgeHeader *header, uint32_t step);
+uint8_t *bridge_observations(BridgeHeader *header, uint32_t step);
+float *bridge_rewards(BridgeHeader *header, uint32_t step);
+uint8_t *bridge_dones(BridgeHeader *header, uint32_t step);
+
+// waits until the counter is different from "value" or the bridge is closed, spinning
+// for a while before sleeping on the futex. Returns the new value of the counter
+uint32_t bridge_wait(BridgeHeader *header, atomic_uint *counter, uint32_t value);
+void bridge_publish(atomic_uint *counter, uint32_t value);
+
+// creates (and sizes) or opens the file of the bridge and maps it
+BridgeHeader *bridge_create(const char *path, uint32_t numEnvs, uint32_t slots);
+BridgeHeader *bridge_open(const char *path);
+void bridge_close(BridgeHeader *header);
+
+#endif // BRIDGE_H
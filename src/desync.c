@@ -0,0 +1,220 @@
+// desync: checks the simulation is deterministic
+//
+// it runs a replay and compares the state hash of every tick, either against a
+// second run on this same build or against the hash log written by another build
+// (e.g. one compiled with -O0 and the other one with -O3), and reports the first
+// tick where they diverge with the parts of the state that are different
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CCFuncs.h"
+#include "panel.h"
+#include "replay.h"
+
+void print_usage(const char *program) {
+    printf("Usage:\n");
+    printf("  %s <replay>                 runs the replay twice and compares every tick\n", program);
+    printf("  %s <replay> <hash-log>      compares against the hash log of another build\n", program);
+    printf("  %s -o <hash-log> <replay>   writes the hash log of this build\n", program);
+    printf("  %s -r <ticks> <seed> <out>  creates a replay with random input\n", program);
+}
+
+void print_block(PanelBlock *block) {
+    printf(" %d:%3d%c%c%c%c", block->type, block->currentY,
+        block->inCombo ? 'c' : '-',
+        block->addedToCombo ? 'a' : '-',
+        block->falling ? 'f' : '-',
+        block->chaining ? 'h' : '-');
+}
+
+void print_row(Panel *panel, int row) {
+    printf("    row %2d:", row);
+    for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+        print_block(get_block(panel, row, col));
+    }
+    printf("\n");
+}
+
+void print_misc(Panel *panel) {
+    printf("    cursor (%d, %d), falling time %d, chain %d, %u cleared, %zu combos:",
+        panel->cursor.x, panel->cursor.y, panel->fallingTime, panel->chain, panel->clearedBlocks,
+        panel->combos.count);
+
+    for(size_t i = 0; i < panel->combos.count; i++) {
+        Combo *combo = &panel->combos.items[i];
+        printf(" [%zu blocks, %d ticks]", combo->count, combo->time);
+    }
+    printf("\n");
+}
+
+// prints the parts of the state that don't match, "b" can be NULL when the
+// other state is only known by its hash
+void print_diff(Panel *a, PanelStateHash *hashA, Panel *b, PanelStateHash *hashB) {
+    printf("  (cells are type:currentY followed by the inCombo, addedToCombo, falling and chaining flags)\n");
+
+    if(hashA->misc != hashB->misc) {
+        printf("  cursor, falling time, chain, cleared blocks or combos differ\n");
+        print_misc(a);
+        if(b != NULL) print_misc(b);
+    }
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        if(hashA->rows[row] == hashB->rows[row]) continue;
+
+        printf("  row %d differs\n", row);
+        print_row(a, row);
+        if(b != NULL) print_row(b, row);
+    }
+}
+
+void panel_tick(Panel *panel, Replay *replay, size_t tick) {
+    panel_apply_input(panel, replay->items[tick]);
+    panel_update(panel);
+}
+
+int run_twice(Replay *replay) {
+    Panel a = {0};
+    Panel b = {0};
+    panel_init(&a, replay->seed);
+    panel_init(&b, replay->seed);
+
+    int result = 0;
+
+    for(size_t tick = 0; tick < replay->count; tick++) {
+        panel_tick(&a, replay, tick);
+        panel_tick(&b, replay, tick);
+
+        PanelStateHash hashA, hashB;
+        panel_state_hash(&a, &hashA);
+        panel_state_hash(&b, &hashB);
+
+        if(hashA.full != hashB.full) {
+            printf("First divergence at tick %zu\n", tick);
+            print_diff(&a, &hashA, &b, &hashB);
+            result = 1;
+            break;
+        }
+    }
+
+    if(result == 0) printf("%zu ticks, no divergence\n", replay->count);
+
+    return result;
+}
+
+int compare_log(Replay *replay, const char *logPath) {
+    FILE *f = fopen(logPath, "r");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", logPath);
+        return 1;
+    }
+
+    Panel panel = {0};
+    panel_init(&panel, replay->seed);
+
+    int result = 0;
+    size_t tick = 0;
+
+    for(; tick < replay->count; tick++) {
+        panel_tick(&panel, replay, tick);
+
+        size_t logTick;
+        PanelStateHash logHash;
+        if(!hashlog_read(f, &logTick, &logHash) || logTick != tick) {
+            printf("The hash log ends at tick %zu but the replay has %zu ticks\n", tick, replay->count);
+            result = 1;
+            break;
+        }
+
+        PanelStateHash hash;
+        panel_state_hash(&panel, &hash);
+
+        if(hash.full != logHash.full) {
+            printf("First divergence at tick %zu, the state of this build is:\n", tick);
+            print_diff(&panel, &hash, NULL, &logHash);
+            result = 1;
+            break;
+        }
+    }
+
+    if(result == 0) printf("%zu ticks, no divergence\n", tick);
+
+    fclose(f);
+    return result;
+}
+
+int write_log(Replay *replay, const char *logPath) {
+    FILE *f = fopen(logPath, "w");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", logPath);
+        return 1;
+    }
+
+    Panel panel = {0};
+    panel_init(&panel, replay->seed);
+
+    for(size_t tick = 0; tick < replay->count; tick++) {
+        panel_tick(&panel, replay, tick);
+
+        PanelStateHash hash;
+        panel_state_hash(&panel, &hash);
+        hashlog_write(f, tick, &hash);
+    }
+
+    fclose(f);
+    return 0;
+}
+
+int random_replay(size_t ticks, uint64_t seed, const char *outPath) {
+    Replay replay = { .seed = seed };
+    uint64_t state = seed;
+
+    for(size_t i = 0; i < ticks; i++) {
+        // a third of the ticks have input, which is enough to keep the board busy
+        uint64_t r = splitmix64_next(&state);
+        da_append(&replay, r % 3 == 0 ? (uint8_t)((r >> 8) & 0x1f) : 0);
+    }
+
+    int result = replay_save(&replay, outPath) ? 0 : 1;
+    replay_free(&replay);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    zobrist_init();
+
+    if(argc == 5 && strcmp(argv[1], "-r") == 0) {
+        return random_replay(strtoull(argv[2], NULL, 10), strtoull(argv[3], NULL, 10), argv[4]);
+    }
+
+    const char *replayPath = NULL;
+    const char *logPath = NULL;
+    bool writeLog = false;
+
+    if(argc == 4 && strcmp(argv[1], "-o") == 0) {
+        logPath = argv[2];
+        replayPath = argv[3];
+        writeLog = true;
+    } else if(argc == 2 || argc == 3) {
+        replayPath = argv[1];
+        if(argc == 3) logPath = argv[2];
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    Replay replay;
+    if(!replay_load(&replay, replayPath)) return 1;
+
+    int result;
+    if(writeLog) {
+        result = write_log(&replay, logPath);
+    } else if(logPath != NULL) {
+        result = compare_log(&replay, logPath);
+    } else {
+        result = run_twice(&replay);
+    }
+
+    replay_free(&replay);
+    return result;
+}
@@ -0,0 +1,204 @@
+#include "env.h"
+#include "panel_batch.h"
+#include "threadpool.h"
+#include "CCFuncs.h"
+
+// the panels are simulated PANEL_BATCH_LANES at a time with the batch engine,
+// the lanes after the last panel are simulated too but nobody reads them
+struct Env {
+    int numEnvs;
+    int numBatches;
+    int maxSteps;
+    uint64_t seed;
+
+    PanelBatch *batches;
+    // the batch engine doesn't have a cursor, it's kept here
+    struct { int x, y; } *cursors;
+    uint32_t *steps;
+    uint32_t *episodes;
+
+    ThreadPool *pool; // NULL when the panels are stepped on the calling thread
+
+    // the buffers of the running step, read by the tasks
+    const uint8_t *actions;
+    uint8_t *observations;
+    float *rewards;
+    uint8_t *dones;
+};
+
+// a task steps this many batches so the workers have enough work to steal
+#define ENV_BATCHES_PER_TASK 4
+
+typedef struct {
+    Env *env;
+    int firstBatch;
+} EnvTask;
+
+Env *env_create(int numEnvs, uint64_t seed, int maxSteps, int threads) {
+    assert(numEnvs > 0 && "An env needs at least a panel");
+    zobrist_init();
+
+    Env *env = calloc(1, sizeof(Env));
+    assert(env != NULL && "Not enough memory");
+
+    env->numEnvs = numEnvs;
+    env->numBatches = (numEnvs + PANEL_BATCH_LANES - 1) / PANEL_BATCH_LANES;
+    env->maxSteps = maxSteps;
+    env->seed = seed;
+
+    // the vectors of the batches need to be aligned to their size
+    env->batches = aligned_alloc(64, (sizeof(PanelBatch) * env->numBatches + 63) / 64 * 64);
+    env->cursors = calloc(env->numBatches * PANEL_BATCH_LANES, sizeof(*env->cursors));
+    env->steps = calloc(env->numBatches * PANEL_BATCH_LANES, sizeof(uint32_t));
+    env->episodes = calloc(env->numBatches * PANEL_BATCH_LANES, sizeof(uint32_t));
+    assert(env->batches != NULL && env->cursors != NULL && env->steps != NULL && env->episodes != NULL
+        && "Not enough memory");
+
+    if(threads != 1 && env->numBatches > 1) env->pool = threadpool_create(threads);
+
+    return env;
+}
+
+void env_destroy(Env *env) {
+    if(env->pool != NULL) threadpool_destroy(env->pool);
+    free(env->batches);
+    free(env->cursors);
+    free(env->steps);
+    free(env->episodes);
+    free(env);
+}
+
+int env_num_envs(Env *env) {
+    return env->numEnvs;
+}
+
+int env_observation_size(void) {
+    return ENV_OBSERVATION_SIZE;
+}
+
+// every episode of every panel has its own board
+static void start_episode(Env *env, int index) {
+    uint64_t state = env->seed ^ ((uint64_t)index << 32 | env->episodes[index]);
+    Panel panel = {0};
+    panel_init(&panel, splitmix64_next(&state));
+
+    PanelBatch *batch = &env->batches[index / PANEL_BATCH_LANES];
+    panel_batch_load(batch, index % PANEL_BATCH_LANES, &panel);
+    env->cursors[index].x = panel.cursor.x;
+    env->cursors[index].y = panel.cursor.y;
+    env->steps[index] = 0;
+    env->episodes[index]++;
+}
+
+static void write_observation(Env *env, int index, uint8_t *observation) {
+    PanelBatch *batch = &env->batches[index / PANEL_BATCH_LANES];
+    int lane = index % PANEL_BATCH_LANES;
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            uint8_t flags = batch->flags[row][col][lane];
+            *observation++ = batch->type[row][col][lane]
+                | (flags & PANEL_BATCH_IN_COMBO ? ENV_CELL_IN_COMBO : 0)
+                | (flags & PANEL_BATCH_FALLING ? ENV_CELL_FALLING : 0);
+        }
+    }
+
+    *observation++ = env->cursors[index].x;
+    *observation++ = env->cursors[index].y;
+}
+
+static bool is_lane_empty(PanelBatch *batch, int lane) {
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            if(batch->type[row][col][lane] != PANEL_BLOCK_NONE) return false;
+        }
+    }
+    return true;
+}
+
+void env_reset(Env *env, uint8_t *observations) {
+    for(int i = 0; i < env->numBatches * PANEL_BATCH_LANES; i++) {
+        env->episodes[i] = 0;
+        start_episode(env, i);
+    }
+
+    for(int i = 0; i < env->numEnvs; i++) {
+        write_observation(env, i, observations + i * ENV_OBSERVATION_SIZE);
+    }
+}
+
+// same as panel_apply_input: the cursor moves first (horizontal before vertical) and then swaps
+static void apply_action(Env *env, PanelBatch *batch, int index, uint8_t action) {
+    int x = env->cursors[index].x;
+    int y = env->cursors[index].y;
+
+    if(action & PANEL_INPUT_RIGHT) x++;
+    else if(action & PANEL_INPUT_LEFT) x--;
+    if(action & PANEL_INPUT_DOWN) y++;
+    else if(action & PANEL_INPUT_UP) y--;
+
+    x = MAX(MIN(x, PANEL_NUM_OF_COLS - 2), 0);
+    y = MAX(MIN(y, PANEL_NUM_OF_ROWS - 1), 0);
+    env->cursors[index].x = x;
+    env->cursors[index].y = y;
+
+    if(action & PANEL_INPUT_SWAP) panel_batch_swap(batch, index % PANEL_BATCH_LANES, y, x);
+}
+
+static void step_batch(Env *env, int b) {
+    PanelBatch *batch = &env->batches[b];
+    int first = b * PANEL_BATCH_LANES;
+    int last = MIN(first + PANEL_BATCH_LANES, env->numEnvs);
+    uint32_t cleared[PANEL_BATCH_LANES];
+
+    for(int i = first; i < last; i++) {
+        apply_action(env, batch, i, env->actions[i]);
+        cleared[i - first] = batch->clearedBlocks[i - first];
+    }
+
+    panel_batch_update(batch);
+
+    for(int i = first; i < last; i++) {
+        int lane = i - first;
+        env->rewards[i] = batch->clearedBlocks[lane] - cleared[lane];
+        env->steps[i]++;
+
+        bool done = env->steps[i] >= (uint32_t)env->maxSteps || is_lane_empty(batch, lane);
+        env->dones[i] = done;
+        if(done) start_episode(env, i);
+
+        write_observation(env, i, env->observations + i * ENV_OBSERVATION_SIZE);
+    }
+}
+
+static void step_task(void *arg, int worker) {
+    (void)worker;
+    EnvTask *task = arg;
+    int last = MIN(task->firstBatch + ENV_BATCHES_PER_TASK, task->env->numBatches);
+
+    for(int b = task->firstBatch; b < last; b++) {
+        step_batch(task->env, b);
+    }
+}
+
+void env_step_batch(Env *env, const uint8_t *actions, uint8_t *observations, float *rewards, uint8_t *dones) {
+    env->actions = actions;
+    env->observations = observations;
+    env->rewards = rewards;
+    env->dones = dones;
+
+    if(env->pool == NULL) {
+        for(int b = 0; b < env->numBatches; b++) step_batch(env, b);
+        return;
+    }
+
+    // the tasks live on the stack since the call waits for all of them
+    int numTasks = (env->numBatches + ENV_BATCHES_PER_TASK - 1) / ENV_BATCHES_PER_TASK;
+    EnvTask tasks[numTasks];
+
+    for(int i = 0; i < numTasks; i++) {
+        tasks[i] = (EnvTask){ .env = env, .firstBatch = i * ENV_BATCHES_PER_TASK };
+        threadpool_submit(env->pool, step_task, &tasks[i]);
+    }
+    threadpool_wait(env->pool);
+}
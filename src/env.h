@@ -0,0 +1,45 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdint.h>
+
+#include "panel.h"
+
+// the API of libtetrisattack.so, used to train agents without a window: many
+// headless panels are stepped with a single call and everything is read from
+// and written to buffers owned by the caller, so no memory is allocated per step
+#define ENV_API __attribute__((visibility("default")))
+
+// the observation of a panel, ENV_OBSERVATION_SIZE bytes:
+//   [0, 72)  one byte per cell, row by row from the top: the PanelBlockType in
+//            the low 3 bits, ENV_CELL_IN_COMBO and ENV_CELL_FALLING
+//   72       cursor column (the left block of the swap)
+//   73       cursor row
+#define ENV_OBSERVATION_SIZE (PANEL_NUM_OF_CELLS + 2)
+#define ENV_CELL_TYPE_MASK 0x07
+#define ENV_CELL_IN_COMBO  0x08
+#define ENV_CELL_FALLING   0x10
+
+// an action is the PanelInput flags of a tick, the same byte the replays store.
+// A step is a tick of the panel, exactly what the game does with the keyboard input
+typedef struct Env Env;
+
+// seed gives the boards of every episode of every panel. An episode ends when
+// the board is cleared or after maxSteps, then the panel starts a new one.
+// threads is the workers that step the panels, 0 uses every core and 1 steps
+// them on the calling thread
+ENV_API Env *env_create(int numEnvs, uint64_t seed, int maxSteps, int threads);
+ENV_API void env_destroy(Env *env);
+
+ENV_API int env_num_envs(Env *env);
+ENV_API int env_observation_size(void);
+
+// starts a new episode on every panel, observations has numEnvs * ENV_OBSERVATION_SIZE bytes
+ENV_API void env_reset(Env *env, uint8_t *observations);
+
+// applies an action (numEnvs bytes) to every panel and advances them a tick.
+// rewards are the blocks cleared this step. A panel whose episode ended has
+// done set and its observation is already the first of the next episode
+ENV_API void env_step_batch(Env *env, const uint8_t *actions, uint8_t *observations, float *rewards, uint8_t *dones);
+
+#endif // ENV_H
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "eval.h"
+#include "CCFuncs.h"
+
+const char *EVAL_FEATURE_NAMES[EVAL_NUM_OF_FEATURES] = {
+    [EVAL_COMBO_BLOCKS] = "combo_blocks",
+    [EVAL_ADJACENT] = "adjacent",
+    [EVAL_NEAR_MATCHES] = "near_matches",
+    [EVAL_HOLES] = "holes",
+    [EVAL_HEIGHT] = "height",
+    [EVAL_STACK] = "stack",
+    [EVAL_MAX_HEIGHT] = "max_height",
+    [EVAL_BUMPINESS] = "bumpiness",
+};
+
+#define ROWS_MASK ((1 << PANEL_NUM_OF_ROWS) - 1)
+
+_Static_assert(PANEL_NUM_OF_ROWS <= 16, "A column must fit in a lane");
+_Static_assert(PANEL_NUM_OF_COLS + 2 <= EVAL_PLANE_LANES, "The columns past the last one must be empty");
+_Static_assert(sizeof(EvalBoard) == sizeof(EvalPlane) * PANEL_NUM_OF_BLOCK_TYPES, "The board is the planes of the colors and the combos");
+
+// the columns move with constant shuffles of the plane and a zero plane, the
+// compiler turns them into byte shifts of the whole vector
+#define ZERO_PLANE ((EvalPlane){0})
+
+// lane c gets the column c + 1, c + 2 or c + 3, zeros come in after the last lane
+#define FROM_RIGHT_1(plane) __builtin_shuffle(plane, ZERO_PLANE, (EvalPlane){1, 2, 3, 4, 5, 6, 7, 8})
+#define FROM_RIGHT_2(plane) __builtin_shuffle(plane, ZERO_PLANE, (EvalPlane){2, 3, 4, 5, 6, 7, 8, 8})
+#define FROM_RIGHT_3(plane) __builtin_shuffle(plane, ZERO_PLANE, (EvalPlane){3, 4, 5, 6, 7, 8, 8, 8})
+// lane c gets the column c - 1
+#define FROM_LEFT_1(plane) __builtin_shuffle(plane, ZERO_PLANE, (EvalPlane){8, 0, 1, 2, 3, 4, 5, 6})
+
+// the set bits of every lane
+static inline EvalPlane popcount(EvalPlane x) {
+    x = x - ((x >> 1) & 0x5555);
+    x = (x & 0x3333) + ((x >> 2) & 0x3333);
+    x = (x + (x >> 4)) & 0x0f0f;
+    return (x + (x >> 8)) & 0x001f;
+}
+
+static inline int sum_lanes(EvalPlane x) {
+    int sum = 0;
+    for(int i = 0; i < EVAL_PLANE_LANES; i++) sum += x[i];
+    return sum;
+}
+
+void eval_pack(EvalBoard *board, Panel *panel) {
+    // without branches: every block sets its bit on the plane of its type, the empty
+    // cells on plane 0 (thrown away) and the blocks in a combo on the last one
+    _Alignas(16) uint16_t planes[PANEL_NUM_OF_BLOCK_TYPES + 1][EVAL_PLANE_LANES] = {0};
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = &panel->blocks[row][col];
+            int plane = block->inCombo && block->type != PANEL_BLOCK_NONE ? PANEL_NUM_OF_BLOCK_TYPES : block->type;
+            planes[plane][col] |= 1 << row;
+        }
+    }
+
+    memcpy(board, planes[1], sizeof(EvalBoard));
+}
+
+void eval_features(EvalBoard *board, int features[EVAL_NUM_OF_FEATURES]) {
+    EvalPlane occupied = board->inCombo;
+    // the colors don't overlap so the cells where a pattern starts don't either, the
+    // patterns of every color are merged and counted once at the end
+    EvalPlane vertical = {0};
+    EvalPlane horizontal = {0};
+    EvalPlane nearPair = {0};
+    EvalPlane nearGap = {0};
+    EvalPlane nearRowLeft = {0};
+    EvalPlane nearRowRight = {0};
+
+    // shifting right moves the row below into a bit, shifting left the row above
+    for(int i = 0; i < EVAL_NUM_OF_COLORS; i++) {
+        EvalPlane color = board->colors[i];
+        occupied |= color;
+
+        // a block of the color a swap away from the cell
+        EvalPlane side = FROM_LEFT_1(color) | FROM_RIGHT_1(color);
+        EvalPlane colorVertical = color & (color >> 1);
+        EvalPlane colorHorizontal = color & FROM_RIGHT_1(color);
+        vertical |= colorVertical;
+        horizontal |= colorHorizontal;
+
+        // a pair in a column and the third next to the cell above or below it
+        nearPair |= colorVertical & ((side >> 2) | (side << 1));
+        // two blocks in a column with a gap and the third next to the gap
+        nearGap |= color & (color >> 2) & (side >> 1);
+        // XX_X and X_XX in a row
+        nearRowLeft |= colorHorizontal & FROM_RIGHT_3(color);
+        nearRowRight |= color & FROM_RIGHT_2(colorHorizontal);
+    }
+
+    EvalPlane adjacent = popcount(vertical) + popcount(horizontal);
+    EvalPlane nearMatches = popcount(nearPair) + popcount(nearGap) + popcount(nearRowLeft) + popcount(nearRowRight);
+
+    // every cell below the highest block of the column
+    EvalPlane filled = occupied;
+    filled |= filled << 1;
+    filled |= filled << 2;
+    filled |= filled << 4;
+    filled |= filled << 8;
+    filled &= ROWS_MASK;
+
+    EvalPlane heights = popcount(filled);
+    EvalPlane next = FROM_RIGHT_1(heights);
+    // the difference with the next column, the last column has no next one
+    EvalPlane greater = (EvalPlane)(heights > next);
+    EvalPlane bumps = ((heights - next) & greater) | ((next - heights) & ~greater);
+    bumps &= (EvalPlane){0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0, 0, 0};
+
+    int maxHeight = 0;
+    for(int col = 0; col < PANEL_NUM_OF_COLS; col++) maxHeight = MAX(maxHeight, heights[col]);
+
+    features[EVAL_COMBO_BLOCKS] = sum_lanes(popcount(board->inCombo));
+    features[EVAL_ADJACENT] = sum_lanes(adjacent);
+    features[EVAL_NEAR_MATCHES] = sum_lanes(nearMatches);
+    features[EVAL_HOLES] = sum_lanes(popcount(filled & ~occupied));
+    features[EVAL_HEIGHT] = sum_lanes(heights);
+    features[EVAL_STACK] = sum_lanes(heights * (heights + 1) / 2);
+    features[EVAL_MAX_HEIGHT] = maxHeight;
+    features[EVAL_BUMPINESS] = sum_lanes(bumps);
+}
+
+float eval_score(const EvalWeights *weights, EvalBoard *board) {
+    int features[EVAL_NUM_OF_FEATURES];
+    eval_features(board, features);
+
+    float score = 0;
+    for(int i = 0; i < EVAL_NUM_OF_FEATURES; i++) score += weights->weights[i] * features[i];
+    return score;
+}
+
+bool eval_weights_load(EvalWeights *weights, const char *path) {
+    FILE *f = fopen(path, "r");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+
+    while(fgets(line, sizeof(line), f) != NULL) {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if(comment != NULL) *comment = '\0';
+
+        char name[64];
+        float weight;
+        int fields = sscanf(line, "%63s %f", name, &weight);
+        if(fields == EOF) continue;
+        if(fields != 2) {
+            log_error("%s:%d: expected \"<feature> <weight>\"", path, lineNumber);
+            ok = false;
+            break;
+        }
+
+        int feature = 0;
+        while(feature < EVAL_NUM_OF_FEATURES && strcmp(name, EVAL_FEATURE_NAMES[feature]) != 0) feature++;
+        if(feature == EVAL_NUM_OF_FEATURES) {
+            log_error("%s:%d: unknown feature \"%s\"", path, lineNumber, name);
+            ok = false;
+            break;
+        }
+
+        weights->weights[feature] = weight;
+    }
+
+    fclose(f);
+    return ok;
+}
+
+void eval_weights_write(FILE *f, const EvalWeights *weights) {
+    // %.9g keeps every bit of the float so the weights read back are the same
+    for(int i = 0; i < EVAL_NUM_OF_FEATURES; i++) {
+        fprintf(f, "%s %.9g\n", EVAL_FEATURE_NAMES[i], weights->weights[i]);
+    }
+}
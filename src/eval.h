@@ -0,0 +1,64 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "panel.h"
+
+// the static evaluation of the bots: a weighted sum of features of the board.
+// The board is packed in bit planes so every feature is computed for all the
+// columns at once with vector instructions
+
+// a plane has a lane per column and a bit per row (bit 0 is the top row), the
+// lanes after the last column are always 0
+#define EVAL_PLANE_LANES 8
+typedef uint16_t EvalPlane __attribute__((vector_size(EVAL_PLANE_LANES * 2)));
+
+#define EVAL_NUM_OF_COLORS (PANEL_NUM_OF_BLOCK_TYPES - 1)
+
+typedef struct {
+    // the blocks of every color that aren't in a combo, color 0 is PANEL_BLOCK_YELLOW
+    EvalPlane colors[EVAL_NUM_OF_COLORS];
+    // the blocks in a combo, they're going to be cleared so they can't match anymore
+    EvalPlane inCombo;
+} EvalBoard;
+
+typedef enum {
+    EVAL_COMBO_BLOCKS, // blocks in a combo
+    EVAL_ADJACENT,     // pairs of blocks of the same color next to each other
+    EVAL_NEAR_MATCHES, // pairs (or two blocks with a gap) that a single swap turns into a line of 3
+    EVAL_HOLES,        // empty cells below a block
+    EVAL_HEIGHT,       // sum of the heights of the columns
+    EVAL_STACK,        // sum of h * (h + 1) / 2 of the columns, the higher blocks weigh more
+    EVAL_MAX_HEIGHT,   // height of the tallest column
+    EVAL_BUMPINESS,    // sum of the height differences of the columns next to each other
+    EVAL_NUM_OF_FEATURES,
+} EvalFeature;
+
+typedef struct {
+    float weights[EVAL_NUM_OF_FEATURES];
+} EvalWeights;
+
+// the names used by the weight files, in the order of EvalFeature
+extern const char *EVAL_FEATURE_NAMES[EVAL_NUM_OF_FEATURES];
+
+#define EVAL_DEFAULT_WEIGHTS ((EvalWeights){ .weights = { \
+    [EVAL_COMBO_BLOCKS] = 10,                             \
+    [EVAL_ADJACENT] = 1,                                  \
+    [EVAL_NEAR_MATCHES] = 0.5,                            \
+    [EVAL_STACK] = -0.05,                                 \
+}})
+
+void eval_pack(EvalBoard *board, Panel *panel);
+void eval_features(EvalBoard *board, int features[EVAL_NUM_OF_FEATURES]);
+float eval_score(const EvalWeights *weights, EvalBoard *board);
+
+// the weight file is text, a "<feature> <weight>" per line and # starts a comment.
+// The features that aren't in the file keep the weight they had
+bool eval_weights_load(EvalWeights *weights, const char *path);
+// writes the weights in the format of the weight files
+void eval_weights_write(FILE *f, const EvalWeights *weights);
+
+#endif // EVAL_H
@@ -0,0 +1,287 @@
+// genpuzzles: generates puzzles with a single solution
+//
+// every worker builds boards made of lines of 3 blocks, scrambles them with the
+// puzzle's swaps and keeps the ones the solver proves to have exactly one
+// solution of that length. The puzzles are written to the file as they're found.
+// There are only so many puzzles with few swaps (about 660 with 1), when the boards
+// stop giving new ones it gives up and fails with the ones it found
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "puzzle_solver.h"
+#include "threadpool.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+#define GEN_DEFAULT_COUNT 1000
+#define GEN_DEFAULT_SWAPS 2
+// the generated boards are at most this tall so they stay readable
+#define GEN_MAX_HEIGHT 6
+// table of the solver of every worker
+#define GEN_TTABLE_BYTES (4 << 20)
+// candidates in a row that don't give a new puzzle before giving up, there are
+// only so many unique puzzles with few swaps
+#define GEN_MAX_FAILURES 100000
+
+typedef struct {
+    int swaps;
+    size_t count;
+    uint64_t seed;
+    bool text;
+
+    // shared by the workers, the lock protects the file and the set of puzzles found
+    pthread_mutex_t lock;
+    FILE *out;
+    size_t found;
+    uint64_t *hashes; // open addressing set of the boards written, 0 is empty
+    size_t hashesMask;
+
+    atomic_uint_fast64_t candidates;
+    atomic_uint_fast64_t solved;
+    atomic_uint_fast64_t failures; // candidates since the last puzzle written
+} Generator;
+
+// places lines of 3 blocks of the same color, the board that clears itself
+static bool place_lines(uint64_t *rng, uint8_t types[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS], int lines) {
+    int height[PANEL_NUM_OF_COLS] = {0};
+
+    for(int line = 0; line < lines; line++) {
+        uint8_t type = splitmix64_next(rng) % (PANEL_NUM_OF_BLOCK_TYPES - 1) + 1;
+        bool placed = false;
+
+        // a few tries to find a place where the line doesn't float
+        for(int try = 0; try < 8 && !placed; try++) {
+            if(splitmix64_next(rng) % 2 == 0) {
+                int col = splitmix64_next(rng) % (PANEL_NUM_OF_COLS - 2);
+                int h = height[col];
+                if(height[col + 1] != h || height[col + 2] != h || h >= GEN_MAX_HEIGHT) continue;
+
+                for(int i = 0; i < 3; i++) {
+                    types[PANEL_NUM_OF_ROWS - 1 - h][col + i] = type;
+                    height[col + i]++;
+                }
+            } else {
+                int col = splitmix64_next(rng) % PANEL_NUM_OF_COLS;
+                if(height[col] + 3 > GEN_MAX_HEIGHT) continue;
+
+                for(int i = 0; i < 3; i++) {
+                    types[PANEL_NUM_OF_ROWS - 1 - height[col]][col] = type;
+                    height[col]++;
+                }
+            }
+            placed = true;
+        }
+
+        if(!placed) return false;
+    }
+
+    return true;
+}
+
+// the swaps only exchange two blocks of different colors so they can be undone,
+// a swap with an empty cell would make the block fall
+static bool scramble(uint64_t *rng, uint8_t types[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS], int swaps) {
+    for(int i = 0; i < swaps; i++) {
+        bool swapped = false;
+
+        for(int try = 0; try < 32 && !swapped; try++) {
+            int row = PANEL_NUM_OF_ROWS - 1 - splitmix64_next(rng) % GEN_MAX_HEIGHT;
+            int col = splitmix64_next(rng) % PANEL_SWAPS_PER_ROW;
+            uint8_t left = types[row][col];
+            uint8_t right = types[row][col + 1];
+            if(left == PANEL_BLOCK_NONE || right == PANEL_BLOCK_NONE || left == right) continue;
+
+            types[row][col] = right;
+            types[row][col + 1] = left;
+            swapped = true;
+        }
+
+        if(!swapped) return false;
+    }
+
+    return true;
+}
+
+static bool generate_candidate(Generator *gen, uint64_t *rng, Puzzle *puzzle) {
+    *puzzle = (Puzzle){ .swaps = gen->swaps };
+
+    // more swaps need more lines to make interesting puzzles
+    int lines = 2 + splitmix64_next(rng) % (gen->swaps + 1);
+    if(!place_lines(rng, puzzle->types, lines)) return false;
+    if(!scramble(rng, puzzle->types, gen->swaps)) return false;
+
+    // the scrambled board can't clear anything on its own
+    Panel panel = {0};
+    puzzle_to_panel(puzzle, &panel);
+    panel_settle(&panel);
+    return panel.clearedBlocks == 0;
+}
+
+// returns false if the board was already written
+static bool add_hash(Generator *gen, uint64_t hash) {
+    if(hash == 0) hash = 1;
+
+    size_t i = hash & gen->hashesMask;
+    while(gen->hashes[i] != 0) {
+        if(gen->hashes[i] == hash) return false;
+        i = (i + 1) & gen->hashesMask;
+    }
+
+    gen->hashes[i] = hash;
+    return true;
+}
+
+static void write_puzzle(Generator *gen, Puzzle *puzzle) {
+    Panel panel = {0};
+    puzzle_to_panel(puzzle, &panel);
+
+    pthread_mutex_lock(&gen->lock);
+    if(gen->found < gen->count && add_hash(gen, panel.hash)) {
+        gen->found++;
+        atomic_store_explicit(&gen->failures, 0, memory_order_relaxed);
+
+        if(gen->text) {
+            snprintf(puzzle->name, sizeof(puzzle->name), "gen-%zu", gen->found);
+            puzzle_write(gen->out, puzzle);
+        } else {
+            puzzle_write_binary(gen->out, puzzle);
+        }
+    }
+    pthread_mutex_unlock(&gen->lock);
+}
+
+static bool is_done(Generator *gen) {
+    if(atomic_load_explicit(&gen->failures, memory_order_relaxed) >= GEN_MAX_FAILURES) return true;
+
+    pthread_mutex_lock(&gen->lock);
+    bool done = gen->found >= gen->count;
+    pthread_mutex_unlock(&gen->lock);
+    return done;
+}
+
+static void worker_task(void *arg, int worker) {
+    Generator *gen = arg;
+    // every worker has its own sequence of random numbers. The seed is hashed with
+    // the worker, adding splitmix64's increment would only shift worker 0's sequence
+    uint64_t mixed = gen->seed ^ (uint64_t)worker;
+    uint64_t rng = splitmix64_next(&mixed);
+
+    PuzzleSolverConfig config = PUZZLE_SOLVER_DEFAULT_CONFIG;
+    config.threads = 1;
+    config.maxSolutions = 2;
+    config.ttableBytes = GEN_TTABLE_BYTES;
+
+    PuzzleSolver solver;
+    puzzle_solver_init(&solver, config);
+
+    while(!is_done(gen)) {
+        Puzzle puzzle;
+        atomic_fetch_add_explicit(&gen->candidates, 1, memory_order_relaxed);
+        // reset by write_puzzle when the candidate is a new puzzle
+        atomic_fetch_add_explicit(&gen->failures, 1, memory_order_relaxed);
+        if(!generate_candidate(gen, &rng, &puzzle)) continue;
+
+        PuzzleSolution solution;
+        puzzle_solve(&solver, &puzzle, &solution);
+        atomic_fetch_add_explicit(&gen->solved, 1, memory_order_relaxed);
+
+        if(solution.length == gen->swaps && solution.solutions == 1) write_puzzle(gen, &puzzle);
+    }
+
+    puzzle_solver_free(&solver);
+}
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options] <output file>\n", program);
+    printf("  --count <n>    puzzles to generate (default %d)\n", GEN_DEFAULT_COUNT);
+    printf("  --swaps <n>    swaps of every puzzle, 1 to %d (default %d)\n", PUZZLE_MAX_SWAPS, GEN_DEFAULT_SWAPS);
+    printf("  --seed <n>     seed of the workers' RNG\n");
+    printf("  --threads <n>  workers (default every core)\n");
+    printf("  --text         writes the text format instead of the binary one\n");
+}
+
+int main(int argc, char **argv) {
+    Generator gen = {
+        .swaps = GEN_DEFAULT_SWAPS,
+        .count = GEN_DEFAULT_COUNT,
+        .seed = 1,
+    };
+    int threads = 0;
+    const char *outPath = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--count") == 0 && hasValue) {
+            gen.count = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--swaps") == 0 && hasValue) {
+            gen.swaps = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--seed") == 0 && hasValue) {
+            gen.seed = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--text") == 0) {
+            gen.text = true;
+        } else if(argv[i][0] != '-' && outPath == NULL) {
+            outPath = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(outPath == NULL || gen.swaps < 1 || gen.swaps > PUZZLE_MAX_SWAPS) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    gen.out = fopen(outPath, gen.text ? "w" : "wb");
+    if(gen.out == NULL) {
+        log_error("Couldn't open \"%s\"", outPath);
+        return 1;
+    }
+    if(!gen.text) puzzle_write_binary_header(gen.out);
+
+    // the set is kept at most half full
+    size_t hashesSize = 1;
+    while(hashesSize < gen.count * 2) hashesSize *= 2;
+    gen.hashes = calloc(hashesSize, sizeof(uint64_t));
+    assert(gen.hashes != NULL && "Not enough memory");
+    gen.hashesMask = hashesSize - 1;
+    pthread_mutex_init(&gen.lock, NULL);
+
+    zobrist_init();
+
+    ThreadPool *pool = threadpool_create(threads);
+    double start = now_seconds();
+
+    for(int i = 0; i < pool->numWorkers; i++) {
+        threadpool_submit(pool, worker_task, &gen);
+    }
+    threadpool_wait(pool);
+
+    double elapsed = now_seconds() - start;
+    uint64_t candidates = atomic_load(&gen.candidates);
+    uint64_t solved = atomic_load(&gen.solved);
+
+    printf("%zu puzzles of %d swaps in %.3fs (%.0f per minute, %d workers)\n",
+        gen.found, gen.swaps, elapsed, gen.found / elapsed * 60, pool->numWorkers);
+    printf("  %llu boards built, %llu solved, %.1f%% of the solved were kept\n",
+        (unsigned long long)candidates, (unsigned long long)solved, solved > 0 ? 100.0 * gen.found / solved : 0.0);
+
+    // the puzzles found are still written, but the file has less than asked
+    bool complete = gen.found >= gen.count;
+    if(!complete) {
+        log_error("Gave up after %d boards in a row without a new puzzle, only %zu of %zu were found",
+            GEN_MAX_FAILURES, gen.found, gen.count);
+    }
+
+    threadpool_destroy(pool);
+    pthread_mutex_destroy(&gen.lock);
+    free(gen.hashes);
+
+    bool ok = !ferror(gen.out);
+    fclose(gen.out);
+    return ok && complete ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+#include "input_queue.h"
+
+void input_queue_init(InputQueue *queue) {
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+}
+
+bool input_queue_push(InputQueue *queue, InputEvent event) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if(tail - head == INPUT_QUEUE_SIZE) return false;
+
+    queue->events[tail % INPUT_QUEUE_SIZE] = event;
+    // the event is written before the reader can see it
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool input_queue_peek(InputQueue *queue, InputEvent *event) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if(head == tail) return false;
+
+    *event = queue->events[head % INPUT_QUEUE_SIZE];
+    return true;
+}
+
+void input_queue_pop(InputQueue *queue) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    // the event is read before the writer can reuse its slot
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+}
@@ -0,0 +1,39 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// the keys pressed, from the thread that reads them to the simulation (and back
+// once they're applied, to measure the latency). A single writer and a single
+// reader, none of them takes a lock
+typedef struct {
+    double time;   // now_seconds() when a poll of the window got the key, not when it was pressed
+    uint8_t input; // PanelInput flags
+
+    // filled by the simulation when the key is applied
+    double appliedTime;
+    uint64_t tick;
+} InputEvent;
+
+// a power of two, there's never close to this many keys waiting
+#define INPUT_QUEUE_SIZE 256
+
+typedef struct {
+    InputEvent events[INPUT_QUEUE_SIZE];
+    // they only grow, the index of an event is the counter modulo INPUT_QUEUE_SIZE.
+    // Each one is written by a single thread, on its own cache line
+    _Alignas(64) atomic_size_t head; // next event to read
+    _Alignas(64) atomic_size_t tail; // next event to write
+} InputQueue;
+
+void input_queue_init(InputQueue *queue);
+// returns false (and the event is lost) when the queue is full
+bool input_queue_push(InputQueue *queue, InputEvent event);
+// the oldest event without taking it, false when the queue is empty
+bool input_queue_peek(InputQueue *queue, InputEvent *event);
+void input_queue_pop(InputQueue *queue);
+
+#endif // INPUT_QUEUE_H
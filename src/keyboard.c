@@ -0,0 +1,52 @@
+#include <stddef.h>
+
+#include "raylib.h"
+#include "keyboard.h"
+#include "panel.h"
+#include "timer.h"
+
+// raylib doesn't expose GLFW's header, these are the parts of it that are used.
+// raylib's key codes are the same as GLFW's
+typedef struct GLFWwindow GLFWwindow;
+typedef void (*GLFWkeyfun)(GLFWwindow *window, int key, int scancode, int action, int mods);
+GLFWkeyfun glfwSetKeyCallback(GLFWwindow *window, GLFWkeyfun callback);
+#define GLFW_PRESS 1
+
+static const struct {
+    int key;
+    uint8_t input;
+} keyMap[] = {
+    { KEY_RIGHT, PANEL_INPUT_RIGHT },
+    { KEY_LEFT, PANEL_INPUT_LEFT },
+    { KEY_DOWN, PANEL_INPUT_DOWN },
+    { KEY_UP, PANEL_INPUT_UP },
+    { KEY_X, PANEL_INPUT_SWAP },
+};
+
+// GLFW's callbacks don't take an argument, there's only one window anyway
+static InputQueue *listeningQueue;
+static GLFWkeyfun raylibCallback;
+
+static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    if(action == GLFW_PRESS) {
+        for(size_t i = 0; i < sizeof(keyMap) / sizeof(keyMap[0]); i++) {
+            if(keyMap[i].key != key) continue;
+
+            // the simulation takes them every tick, it's never close to full
+            InputEvent event = { .time = now_seconds(), .input = keyMap[i].input };
+            input_queue_push(listeningQueue, event);
+        }
+    }
+
+    if(raylibCallback != NULL) raylibCallback(window, key, scancode, action, mods);
+}
+
+void keyboard_listen(InputQueue *queue) {
+    listeningQueue = queue;
+    raylibCallback = glfwSetKeyCallback(GetWindowHandle(), key_callback);
+}
+
+void keyboard_stop(void) {
+    glfwSetKeyCallback(GetWindowHandle(), raylibCallback);
+    listeningQueue = NULL;
+}
@@ -0,0 +1,15 @@
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include <stdbool.h>
+
+#include "input_queue.h"
+
+// the keys of the panel go to the queue the moment a poll of the window gets them,
+// with the time of the poll, instead of being checked once per frame. raylib keeps
+// getting every key too, IsKeyPressed still works. Needs the window to be open
+void keyboard_listen(InputQueue *queue);
+// the keys go to raylib only
+void keyboard_stop(void);
+
+#endif // KEYBOARD_H
@@ -0,0 +1,56 @@
+#include <math.h>
+
+#include "latency.h"
+
+void latency_add(LatencyHistogram *histogram, double seconds) {
+    int bucket = seconds / LATENCY_BUCKET_TIME;
+    if(bucket < 0) bucket = 0;
+    if(bucket >= LATENCY_BUCKETS) bucket = LATENCY_BUCKETS - 1;
+
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->total += seconds;
+    if(seconds > histogram->max) histogram->max = seconds;
+}
+
+double latency_percentile(const LatencyHistogram *histogram, double fraction) {
+    if(histogram->count == 0) return 0;
+
+    // the nearest rank, counted from 1. Without the epsilon 0.07 * 100 would be the 8th
+    uint64_t target = ceil(fraction * histogram->count - 1e-9);
+    if(target < 1) target = 1;
+
+    uint64_t seen = 0;
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if(seen >= target) return (i + 1) * LATENCY_BUCKET_TIME;
+    }
+    return LATENCY_BUCKETS * LATENCY_BUCKET_TIME;
+}
+
+const char *latency_summary(const LatencyHistogram *histogram, const char *name) {
+    static char summary[128];
+    snprintf(summary, sizeof(summary), "%s: p50 %.2f p95 %.2f p99 %.2f ms", name,
+        latency_percentile(histogram, 0.50) * 1000, latency_percentile(histogram, 0.95) * 1000,
+        latency_percentile(histogram, 0.99) * 1000);
+    return summary;
+}
+
+void latency_print(const LatencyHistogram *histogram, const char *name, FILE *f) {
+    fprintf(f, "%s (%llu inputs, mean %.2f ms, max %.2f ms)\n", latency_summary(histogram, name),
+        (unsigned long long)histogram->count,
+        histogram->count > 0 ? histogram->total / histogram->count * 1000 : 0.0, histogram->max * 1000);
+    if(histogram->count == 0) return;
+
+    int bucketsPerRow = 0.001 / LATENCY_BUCKET_TIME;
+    int lastBucket = histogram->max / LATENCY_BUCKET_TIME;
+    if(lastBucket >= LATENCY_BUCKETS) lastBucket = LATENCY_BUCKETS - 1;
+
+    for(int row = 0; row <= lastBucket / bucketsPerRow; row++) {
+        uint64_t count = 0;
+        for(int i = row * bucketsPerRow; i < (row + 1) * bucketsPerRow && i < LATENCY_BUCKETS; i++) {
+            count += histogram->buckets[i];
+        }
+        fprintf(f, "  %3d-%3d ms %6llu\n", row, row + 1, (unsigned long long)count);
+    }
+}
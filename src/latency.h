@@ -0,0 +1,28 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// a histogram of latencies with a resolution of LATENCY_BUCKET_TIME, the ones
+// longer than the last bucket are counted in it
+#define LATENCY_BUCKET_TIME 0.00025
+#define LATENCY_BUCKETS 1000
+
+typedef struct {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint64_t count;
+    double total;
+    double max;
+} LatencyHistogram;
+
+void latency_add(LatencyHistogram *histogram, double seconds);
+// the latency of the given fraction of the samples (0.5 for the median) in seconds,
+// rounded up to the end of its bucket. 0 without samples
+double latency_percentile(const LatencyHistogram *histogram, double fraction);
+// a line like the one of latency_summary and a row per millisecond up to the max
+void latency_print(const LatencyHistogram *histogram, const char *name, FILE *f);
+// "<name>: p50 .. p95 .. p99 .. ms", the string is overwritten on the next call
+const char *latency_summary(const LatencyHistogram *histogram, const char *name);
+
+#endif // LATENCY_H
@@ -1,416 +1,558 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include "raylib.h"
 #include "CCFuncs.h"
+#include "bot.h"
+#include "keyboard.h"
+#include "latency.h"
+#include "pacer.h"
+#include "mcts.h"
+#include "panel.h"
+#include "puzzle.h"
+#include "render.h"
+#include "replay.h"
+#include "timer.h"
+#include "trajectory.h"
+#include "triple_buffer.h"
 
 #define BLOCKS_SPRITESHEET_FILE "./assets/blocks.png"
+#define BLOCKS_ATLAS_FILE "./assets/blocks.atlas"
+#define WEIGHTS_FILE "./assets/weights.txt"
+
+// the maximum time the simulation catches up at once, avoids freezing the game
+// trying to catch up after a long stall
+#define MAX_FRAME_TIME 0.25
+
+// raylib loads OpenGL through glad and doesn't expose its header, glFinish is a
+// pointer filled when the window is created
+typedef void (*PFNGLFINISHPROC)(void);
+extern PFNGLFINISHPROC glad_glFinish;
+#define glFinish glad_glFinish
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --seed <n>          seed used to generate the panel\n");
+    printf("  --record <file>     saves the replay of the game on exit\n");
+    printf("  --replay <file>     plays a recorded replay instead of reading the keyboard\n");
+    printf("  --hash-log <file>   writes the state hash of every tick (verification mode)\n");
+    printf("  --export <file>     appends the board, action and reward of every tick (training data)\n");
+    printf("  --bot <beam|mcts>   lets a bot play\n");
+    printf("  --weights <file>    weights of the beam bot's evaluation (default %s)\n", WEIGHTS_FILE);
+    printf("  --puzzle <file>     puzzle mode, R restarts the puzzle and N goes to the next one\n");
+    printf("  --puzzle-index <n>  puzzle of the file to start with (default 0)\n");
+    printf("  --render-stats      shows the draw calls and CPU time of every frame\n");
+    printf("  --latency           shows the latency of the keys from the poll that gets them, the histograms are printed on exit\n");
+}
 
-// how many columns per row should contain a panel
-#define PANEL_NUM_OF_COLS 6
-#define PANEL_NUM_OF_ROWS 12
+// the state of the puzzle mode
+typedef struct {
+    Puzzles puzzles;
+    size_t index;
+    int swapsLeft;
+} PuzzleMode;
 
-// the time that needs to be waited to make the blocks fall
-#define PANEL_BLOCK_FALLING_TIME 0.05
+void puzzle_mode_start(PuzzleMode *mode, Panel *panel, size_t index) {
+    mode->index = index % mode->puzzles.count;
+    Puzzle *puzzle = &mode->puzzles.items[mode->index];
 
- // the time we need to wait before starting to pop the combo's block
-#define PANEL_POP_IDLE_DURATION 0.5
-// the duration of each block pop
-#define PANEL_POP_BLOCK_DURATION 0.1
+    puzzle_to_panel(puzzle, panel);
+    mode->swapsLeft = puzzle->swaps;
+}
 
-#define MIN(a, b) ((a) > (b) ? (b) : (a))
-#define MAX(a, b) ((a) < (b) ? (b) : (a))
+// counts the swaps done and drops the ones that go over the puzzle's swaps,
+// returns the input that is left to apply
+uint8_t puzzle_mode_input(PuzzleMode *mode, Panel *panel, uint8_t input) {
+    // the cursor moves before swapping, so the swap is checked where the cursor ends
+    panel_apply_input(panel, input & ~PANEL_INPUT_SWAP);
+    if(!(input & PANEL_INPUT_SWAP) || mode->swapsLeft == 0) return 0;
 
-typedef enum {
-    PANEL_BLOCK_NONE = 0,
-    PANEL_BLOCK_YELLOW,
-    PANEL_BLOCK_RED,
-    PANEL_BLOCK_PURPLE,
-    PANEL_BLOCK_GREEN,
-    PANEL_BLOCK_BLUE,
-    PANEL_BLOCK_DARK_BLUE,
-} PanelBlockType;
+    // only the swaps that do something are counted
+    if(panel_legal_swaps(panel) & PANEL_SWAP_BIT(panel->cursor.y, panel->cursor.x)) mode->swapsLeft--;
+    return PANEL_INPUT_SWAP;
+}
 
-typedef struct {
-    PanelBlockType type;
-    float currentY; // used to fall smoothly
-    bool inCombo;
-    bool addedToCombo; // used to avoid creating new combos
+void puzzle_mode_draw(PuzzleMode *mode, Panel *panel) {
+    Puzzle *puzzle = &mode->puzzles.items[mode->index];
+    int x = panel->pos.x + panel->size.x + 40;
+    bool settled = panel->combos.count == 0 && !panel_has_falling_blocks(panel);
 
-    // the actual position on the matrix
-    int row;
-    int col;
+    DrawText(TextFormat("Puzzle %zu/%zu: %s", mode->index + 1, mode->puzzles.count, puzzle->name), x, 40, 30, WHITE);
+    DrawText(TextFormat("Swaps left: %d", mode->swapsLeft), x, 80, 30, WHITE);
 
-    bool falling;
-} PanelBlock;
+    if(panel_is_empty(panel)) {
+        DrawText("Cleared! Press N for the next puzzle", x, 140, 30, GREEN);
+    } else if(mode->swapsLeft == 0 && settled) {
+        DrawText("Out of swaps, press R to try again", x, 140, 30, RED);
+    }
+}
 
+// what the render thread gets from the simulation after every tick, it's a copy
+// so the simulation can go on while it's drawn. The puzzles are shared, they
+// never change
 typedef struct {
-    PanelBlock **items; // All the blocks positions that conform a combo
-    size_t count;
-    size_t capacity;
-    float time; // life time of the combo since its creation
-} Combo;
-
+    Panel panel;
+    PuzzleMode puzzleMode;
+    size_t tick;
+} GameSnapshot;
+
+// the simulation runs on its own thread at PANEL_TICKS_PER_SECOND no matter how
+// long the frames take, everything below is only touched by that thread except
+// the atomics and the snapshots
 typedef struct {
-    Vector2 pos;
-    Vector2 size;
-    PanelBlock blocks[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS];
-
-    struct {
-        int x; int y;
-    } cursor;
-
-    float fallingTime; // used to count when the block should fall
-
-    struct {
-        Combo *items;
-        size_t count;
-        size_t capacity;
-    } combos;
-} Panel;
-
-Texture2D blocks;
+    Panel panel;
+    size_t tick;
+    uint64_t seed;
+
+    Replay *replay;
+    bool replaying; // the input comes from the replay, otherwise it's recorded on it
+    FILE *hashLog;
+    TrajectoryWriter *exporter; // NULL when the ticks aren't exported
+    PuzzleMode *puzzleMode;     // NULL outside of the puzzle mode
+    BeamBot *beamBot;
+    MctsBot *mctsBot;
+    uint8_t botInput; // decided after the last tick, for the next one
+
+    GameSnapshot slots[3];
+    TripleBuffer snapshots;
+
+    InputQueue inputs;         // keys pressed waiting for their tick
+    InputQueue applied;        // keys applied, back to the render thread to measure the latency
+    bool measureLatency;
+    atomic_int puzzleRequest;  // puzzle the render thread wants to start, -1 for none
+
+    // the render thread can ask for the ticks due before its next frame to run
+    // right away, after it read the keys, instead of when they're due
+    pthread_mutex_t lock;
+    pthread_cond_t wake;   // the simulation waits on it for the next tick
+    pthread_cond_t ticked; // the render thread waits on it for the ticks it asked for
+    double nextTick;       // when the next tick is due
+    double runUntil;       // the ticks due before this run as soon as they can
+    bool running;
+} Game;
+
+// the keys pressed before the time of the tick, a key that is already pressed
+// in this tick waits for the next one so pressing it twice quickly isn't lost
+uint8_t game_take_keys(Game *game, double tickTime) {
+    uint8_t input = 0;
+    InputEvent event;
+
+    while(input_queue_peek(&game->inputs, &event) && event.time <= tickTime && !(input & event.input)) {
+        input |= event.input;
+        input_queue_pop(&game->inputs);
+
+        if(game->measureLatency) {
+            event.appliedTime = now_seconds();
+            event.tick = game->tick;
+            input_queue_push(&game->applied, event);
+        }
+    }
 
-PanelBlock *get_block(Panel *panel, int row, int col) {
-    return &panel->blocks[row][col];
+    return input;
 }
 
-void gravity(Panel *panel) {
-    panel->fallingTime += GetFrameTime();
-
-    if(panel->fallingTime < PANEL_BLOCK_FALLING_TIME) return;
-
-    panel->fallingTime = 0;
+// tickTime is when the tick was due, the keys pressed after it are left for the next one
+void game_tick(Game *game, double tickTime) {
+    Panel *panel = &game->panel;
 
-    // iterate from panel bottom to top
-    // we skip the bottom row since gravity will not affect it
-    for(int row = PANEL_NUM_OF_ROWS - 2; row >= 0; row--) {
-        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
-            PanelBlock *block = get_block(panel, row, col);
-            if(block->type == PANEL_BLOCK_NONE || block->inCombo) continue;
+    int puzzle = atomic_exchange(&game->puzzleRequest, -1);
+    if(puzzle >= 0 && game->puzzleMode != NULL) puzzle_mode_start(game->puzzleMode, panel, puzzle);
 
-            PanelBlock *botBlock = get_block(panel, row + 1, col);
-            if(botBlock->type != PANEL_BLOCK_NONE) continue;
+    uint8_t input = game_take_keys(game, tickTime) | game->botInput;
 
-            PanelBlock temp = *block;
-            *block = *botBlock;
-            *botBlock = temp;
-
-            // only change the block that is not empty
-            botBlock->row++;
+    if(game->replaying) {
+        // once the replay ends the panel just keeps going without input
+        if(game->tick >= game->replay->count) {
+            if(game->hashLog != NULL) {
+                fclose(game->hashLog);
+                game->hashLog = NULL;
+            }
+            input = 0;
+        } else {
+            input = game->replay->items[game->tick];
         }
+    } else {
+        da_append(game->replay, input);
     }
-}
 
-// returns true if the given block is:
-// - not outside the blocks array boundaries
-// - not part of a combo
-// - the same type as the given t
-// - is not falling
-bool is_block_comboable(Panel *panel, int row, int col, PanelBlockType t) {
-    if(row >= PANEL_NUM_OF_ROWS || row < 0 || col >= PANEL_NUM_OF_COLS || col < 0)
-        return false;
-
-    PanelBlock b = panel->blocks[row][col];
-    return !b.addedToCombo && !b.falling && b.type == t;
-}
+    TrajectoryRecord record = { .seed = game->seed, .tick = game->tick, .action = input };
+    uint32_t cleared = panel->clearedBlocks;
+    if(game->exporter != NULL) trajectory_record_board(&record, panel);
 
-void block_smooth_falling(PanelBlock *block) {
-    if(block->type == PANEL_BLOCK_NONE) return;
-    float dt = GetFrameTime();
-
-    if(block->currentY < block->row) {
-        // the falling animation time should be the same as the actual falling
-        block->currentY += 1.0 / PANEL_BLOCK_FALLING_TIME * dt;
-        block->falling = true;
-    } else if(block->currentY > block->row) {
-        block->currentY = block->row;
-        block->falling = false;
+    if(game->puzzleMode != NULL) {
+        input = puzzle_mode_input(game->puzzleMode, panel, input);
+        // the swaps over the limit of the puzzle don't happen
+        record.action = (record.action & ~PANEL_INPUT_SWAP) | input;
     }
-}
 
-// Returns true if a combo was found
-bool find_block_combo(Panel *panel, int row, int col) {
-    PanelBlock *curBlock = get_block(panel, row, col);
-    // if "addedToCombo" is true it means it's part of an existing combo
-    if(curBlock->type == PANEL_BLOCK_NONE
-        || curBlock->addedToCombo
-        || curBlock->falling) return false;
-
-    // here we check the right blocks
-    int xCount = 1;
-    while(is_block_comboable(panel, row, col + xCount, curBlock->type)) xCount++;
-
-    // and here we check the bottom blocks
-    int yCount = 1;
-    while(is_block_comboable(panel, row + yCount, col, curBlock->type)) yCount++;
-
-    bool foundCombo = false;
-
-    // here we mark the this block as part of the combo, this allows "create_combo" function
-    // to add all blocks accordingly
-    if(!curBlock->inCombo && (xCount >= 3 || yCount >= 3)) {
-        curBlock->inCombo = true;
-        foundCombo = true;
-    }
+    panel_apply_input(panel, input);
+    panel_update(panel);
 
-    // we must set the other blocks as "inCombo" since they will not check
-    // top or left blocks
-    if(xCount >= 3) {
-        while(xCount > 1) {
-            PanelBlock *b = get_block(panel, row, col + xCount - 1);
-            b->inCombo = true;
-            xCount--;
-        }
+    if(game->exporter != NULL) {
+        record.reward = panel->clearedBlocks - cleared;
+        record.chain = panel->chain;
+        trajectory_writer_append(game->exporter, &record);
     }
 
-    if(yCount >= 3) {
-        while(yCount > 1) {
-            PanelBlock *b = get_block(panel, row + yCount - 1, col);
-            b->inCombo = true;
-            yCount--;
-        }
+    if(game->hashLog != NULL) {
+        PanelStateHash hash;
+        panel_state_hash(panel, &hash);
+        hashlog_write(game->hashLog, game->tick, &hash);
     }
 
-    return foundCombo;
+    game->tick++;
+
+    // the bots see the board of this tick and press their keys on the next one
+    game->botInput = 0;
+    if(game->beamBot != NULL) game->botInput = beam_bot_input(game->beamBot, panel);
+    if(game->mctsBot != NULL) game->botInput = mcts_bot_input(game->mctsBot, panel);
 }
 
-void create_combo(Panel *panel) {
-    Combo combo = {0};
+void game_publish(Game *game) {
+    GameSnapshot *snapshot = triple_buffer_back(&game->snapshots);
+    snapshot->panel = game->panel;
+    if(game->puzzleMode != NULL) snapshot->puzzleMode = *game->puzzleMode;
+    snapshot->tick = game->tick;
+    triple_buffer_publish(&game->snapshots);
+}
 
-    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
-        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
-            PanelBlock *block = get_block(panel, row, col);
-            if(!block->inCombo || block->addedToCombo) continue;
-            block->addedToCombo = true;
-            da_append(&combo, block);
-        }
+// from the poll that gets a key to the frame that shows it, split in the time until
+// the simulation applies the key and the time until a frame with that tick is
+// presented. The time the key waited in the OS until the poll isn't known, so it's
+// not included. Measured on the render thread with the keys the simulation sends back
+typedef struct {
+    LatencyHistogram pollToTick;
+    LatencyHistogram tickToFrame;
+    LatencyHistogram pollToFrame;
+} InputLatency;
+
+// the keys applied in the ticks before the drawn one are on the screen now
+void input_latency_frame(InputLatency *latency, InputQueue *applied, uint64_t drawnTicks, double presentTime) {
+    InputEvent event;
+    while(input_queue_peek(applied, &event) && event.tick < drawnTicks) {
+        latency_add(&latency->pollToTick, event.appliedTime - event.time);
+        latency_add(&latency->tickToFrame, presentTime - event.appliedTime);
+        latency_add(&latency->pollToFrame, presentTime - event.time);
+        input_queue_pop(applied);
     }
-
-    assert(combo.count > 0 && "You shouldn't call this function if there's no combos available");
-    da_append(&panel->combos, combo);
 }
 
-void panel_update(Panel *panel) {
-    gravity(panel);
+void input_latency_draw(InputLatency *latency, int x, int y) {
+    DrawText(latency_summary(&latency->pollToTick, "poll to tick"), x, y, 20, GREEN);
+    DrawText(latency_summary(&latency->tickToFrame, "tick to frame"), x, y + 25, 20, GREEN);
+    DrawText(latency_summary(&latency->pollToFrame, "poll to frame"), x, y + 50, 20, GREEN);
+}
 
-    bool foundCombo = false;
+void input_latency_print(InputLatency *latency) {
+    latency_print(&latency->pollToTick, "poll to tick", stdout);
+    latency_print(&latency->tickToFrame, "tick to frame", stdout);
+    latency_print(&latency->pollToFrame, "poll to frame", stdout);
+}
 
-    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
-        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
-            PanelBlock *block = get_block(panel, row, col);
-            block_smooth_falling(block);
+void *simulation_thread(void *arg) {
+    Game *game = arg;
 
-            if(find_block_combo(panel, row, col)) foundCombo = true;
+    pthread_mutex_lock(&game->lock);
+    while(game->running) {
+        double nextTick = game->nextTick;
+        if(nextTick > MAX(now_seconds(), game->runUntil)) {
+            struct timespec due = timespec_from_seconds(nextTick);
+            pthread_cond_timedwait(&game->wake, &game->lock, &due);
+            continue;
         }
-    }
+        pthread_mutex_unlock(&game->lock);
 
-    if(foundCombo) create_combo(panel);
-}
+        game_tick(game, nextTick);
+        game_publish(game);
 
-void draw_block(PanelBlock *block, int x, int y, int width, int height) {
-    if(block->inCombo) return;
+        // after a long stall the lost time isn't simulated all at once
+        nextTick += PANEL_TICK_TIME;
+        double now = now_seconds();
+        if(now - nextTick > MAX_FRAME_TIME) nextTick = now;
 
-    // TODO: this should be improved in the future
-    Rectangle rec = {
-        .x = 0,
-        .y = 0,
-        .width = 100,
-        .height = 100,
-    };
-
-    switch(block->type) {
-        case PANEL_BLOCK_YELLOW:    rec.x = 0;   break;
-        case PANEL_BLOCK_RED:       rec.x = 100; break;
-        case PANEL_BLOCK_PURPLE:    rec.x = 200; break;
-        case PANEL_BLOCK_GREEN:     rec.x = 300; break;
-        case PANEL_BLOCK_BLUE:      rec.x = 400; break;
-        case PANEL_BLOCK_DARK_BLUE: rec.x = 500; break;
-        default: return;
+        pthread_mutex_lock(&game->lock);
+        game->nextTick = nextTick;
+        pthread_cond_broadcast(&game->ticked);
     }
+    pthread_mutex_unlock(&game->lock);
 
-    Rectangle dest = {
-        .x = x,
-        .y = y,
-        .width = width,
-        .height = height,
-    };
-    DrawTexturePro(blocks, rec, dest, (Vector2){0, 0}, 0, WHITE);
-
-    if(block->inCombo) {
-        DrawRectangle(x, y, width, height, (Color){255, 255, 255, 120});
-    }
+    return NULL;
 }
 
-void draw_combo_block(PanelBlock *block, int x, int y, int width, int height) {
-    // TODO: this should be improved in the future
-    Rectangle rec = {
-        .x = 0,
-        .y = 0,
-        .width = 100,
-        .height = 100,
-    };
-
-    switch(block->type) {
-        case PANEL_BLOCK_YELLOW:    rec.x = 0;   break;
-        case PANEL_BLOCK_RED:       rec.x = 100; break;
-        case PANEL_BLOCK_PURPLE:    rec.x = 200; break;
-        case PANEL_BLOCK_GREEN:     rec.x = 300; break;
-        case PANEL_BLOCK_BLUE:      rec.x = 400; break;
-        case PANEL_BLOCK_DARK_BLUE: rec.x = 500; break;
-        default: return;
-    }
-
-    Rectangle dest = {
-        .x = x,
-        .y = y,
-        .width = width,
-        .height = height,
-    };
-    DrawTexturePro(blocks, rec, dest, (Vector2){0, 0}, 0, WHITE);
-    DrawRectangle(x, y, width, height, (Color){255, 255, 255, 120});
+// runs now the ticks due before the deadline, so the keys read just before make
+// it to the frame, and waits for them until the limit. A slow tick doesn't hold
+// the frame past it, the frame draws the last snapshot instead
+void game_run_until(Game *game, double deadline, double limit) {
+    struct timespec ts = timespec_from_seconds(limit);
+
+    pthread_mutex_lock(&game->lock);
+    game->runUntil = deadline;
+    pthread_cond_signal(&game->wake);
+    while(game->nextTick <= deadline && pthread_cond_timedwait(&game->ticked, &game->lock, &ts) == 0);
+    pthread_mutex_unlock(&game->lock);
 }
 
-void panel_draw(Panel *panel) {
-    int blockWidth = panel->size.x / PANEL_NUM_OF_COLS;
-    int blockHeight = panel->size.y / PANEL_NUM_OF_ROWS;
+// raylib only remembers the keys of the last PollInputEvents, the frame polls
+// twice (the late latch and EndDrawing) so R and N are checked after both
+void game_puzzle_keys(Game *game, PuzzleMode *shown) {
+    if(IsKeyPressed(KEY_R)) atomic_store(&game->puzzleRequest, (int)shown->index);
+    if(IsKeyPressed(KEY_N)) atomic_store(&game->puzzleRequest, (int)shown->index + 1);
+}
 
-    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
-        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
-            PanelBlock *block = get_block(panel, row, col);
-            if(block->type == PANEL_BLOCK_NONE) continue;
+void game_stop(Game *game) {
+    pthread_mutex_lock(&game->lock);
+    game->running = false;
+    pthread_cond_signal(&game->wake);
+    pthread_mutex_unlock(&game->lock);
+}
 
-            int posX = panel->pos.x + blockWidth * col;
-            int posY = panel->pos.y + blockHeight * block->currentY;
+int main(int argc, char **argv) {
+    uint64_t seed = time(NULL);
+    const char *recordPath = NULL;
+    const char *replayPath = NULL;
+    const char *hashLogPath = NULL;
+    const char *exportPath = NULL;
+    const char *botName = NULL;
+    const char *weightsPath = WEIGHTS_FILE;
+    const char *puzzlePath = NULL;
+    size_t puzzleIndex = 0;
+    bool showRenderStats = false;
+    bool showLatency = false;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--record") == 0 && hasValue) {
+            recordPath = argv[++i];
+        } else if(strcmp(argv[i], "--replay") == 0 && hasValue) {
+            replayPath = argv[++i];
+        } else if(strcmp(argv[i], "--hash-log") == 0 && hasValue) {
+            hashLogPath = argv[++i];
+        } else if(strcmp(argv[i], "--export") == 0 && hasValue) {
+            exportPath = argv[++i];
+        } else if(strcmp(argv[i], "--bot") == 0 && hasValue) {
+            botName = argv[++i];
+        } else if(strcmp(argv[i], "--weights") == 0 && hasValue) {
+            weightsPath = argv[++i];
+        } else if(strcmp(argv[i], "--puzzle") == 0 && hasValue) {
+            puzzlePath = argv[++i];
+        } else if(strcmp(argv[i], "--puzzle-index") == 0 && hasValue) {
+            puzzleIndex = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--render-stats") == 0) {
+            showRenderStats = true;
+        } else if(strcmp(argv[i], "--latency") == 0) {
+            showLatency = true;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
 
-            draw_block(block, posX, posY, blockWidth, blockHeight);
+    PuzzleMode puzzleMode = {0};
+    if(puzzlePath != NULL) {
+        // a replay only has the seed of the panel, not the puzzle
+        if(recordPath != NULL || replayPath != NULL) {
+            log_error("%s", "Replays can't be used in puzzle mode");
+            return 1;
+        }
 
-#ifdef DEBUG
-            const char *info = TextFormat("(%d, %d)", block->col, block->row);
-            DrawText(info, posX + blockWidth / 2, posY + blockHeight / 2, 10, WHITE);
-#endif
+        if(!puzzle_load_file(&puzzleMode.puzzles, puzzlePath)) return 1;
+        if(puzzleMode.puzzles.count == 0) {
+            log_error("\"%s\" has no puzzles", puzzlePath);
+            return 1;
         }
     }
 
-    Rectangle cursorRec = {
-        .x = panel->cursor.x * blockWidth,
-        .y = panel->cursor.y * blockHeight,
-        .width = blockWidth * 2,
-        .height = blockHeight,
-    };
-    DrawRectangleLinesEx(cursorRec, 3, WHITE);
-}
+    Replay replay = {0};
+    if(replayPath != NULL) {
+        if(!replay_load(&replay, replayPath)) return 1;
+        seed = replay.seed;
+    }
+    replay.seed = seed;
+
+    FILE *hashLog = NULL;
+    if(hashLogPath != NULL) {
+        hashLog = fopen(hashLogPath, "w");
+        if(hashLog == NULL) {
+            log_error("Couldn't open \"%s\"", hashLogPath);
+            return 1;
+        }
+    }
 
-void panel_cursor_swap(Panel *panel) {
-    int cursorX = panel->cursor.x;
-    int cursorY = panel->cursor.y;
+    TrajectoryWriter exporter;
+    if(exportPath != NULL && !trajectory_writer_open(&exporter, exportPath)) return 1;
 
-    PanelBlock *left = get_block(panel, cursorY, cursorX);
-    if(left->inCombo) return;
-    PanelBlock *right = get_block(panel, cursorY, cursorX + 1);
-    if(right->inCombo) return;
+    bool useBeamBot = botName != NULL && strcmp(botName, "beam") == 0;
+    bool useMctsBot = botName != NULL && strcmp(botName, "mcts") == 0;
 
-    PanelBlock temp = *left;
+    // loaded before the window is opened so a bad file doesn't leave it open
+    BeamBotConfig beamConfig = BEAM_BOT_DEFAULT_CONFIG;
+    if(useBeamBot && !eval_weights_load(&beamConfig.weights, weightsPath)) return 1;
 
-    *left = *right;
-    *right = temp;
+    // the frames are paced against the vblank instead of with SetTargetFPS, which
+    // sleeps after the frame and makes the input wait for it
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_VSYNC_HINT);
+    InitWindow(1280, 720, "C Tetris Attack");
 
-    if(right->type != PANEL_BLOCK_NONE) right->col++;
-    if(left->type != PANEL_BLOCK_NONE) left->col--;
-}
+    FramePacer pacer;
+    pacer_init(&pacer, GetMonitorRefreshRate(GetCurrentMonitor()));
 
-void player_controller(Panel *panel) {
-    if(IsKeyPressed(KEY_RIGHT)) {
-        // here we substract by 2 because the cursor's length is 2 blocks
-        panel->cursor.x = MIN(panel->cursor.x + 1, PANEL_NUM_OF_COLS - 2);
-    } else if(IsKeyPressed(KEY_LEFT)) {
-        panel->cursor.x = MAX(panel->cursor.x - 1, 0);
+    Game game = {
+        .seed = seed,
+        .replay = &replay,
+        .replaying = replayPath != NULL,
+        .hashLog = hashLog,
+        .exporter = exportPath != NULL ? &exporter : NULL,
+        .puzzleMode = puzzlePath != NULL ? &puzzleMode : NULL,
+    };
+    input_queue_init(&game.inputs);
+    input_queue_init(&game.applied);
+    atomic_init(&game.puzzleRequest, -1);
+    game.running = true;
+    game.nextTick = now_seconds() + PANEL_TICK_TIME;
+    pthread_mutex_init(&game.lock, NULL);
+    // the waits use now_seconds() times
+    pthread_condattr_t condAttr;
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&game.wake, &condAttr);
+    pthread_cond_init(&game.ticked, &condAttr);
+    pthread_condattr_destroy(&condAttr);
+    triple_buffer_init(&game.snapshots, &game.slots[0], &game.slots[1], &game.slots[2]);
+
+    zobrist_init();
+    if(puzzlePath != NULL) {
+        puzzle_mode_start(&puzzleMode, &game.panel, puzzleIndex);
+    } else {
+        panel_init(&game.panel, seed);
     }
 
-    if(IsKeyPressed(KEY_DOWN)) {
-        panel->cursor.y = MIN(panel->cursor.y + 1, PANEL_NUM_OF_ROWS - 1);
-    } else if(IsKeyPressed(KEY_UP)) {
-        panel->cursor.y = MAX(panel->cursor.y - 1, 0);
+    Renderer renderer;
+    if(!renderer_init(&renderer, BLOCKS_SPRITESHEET_FILE, BLOCKS_ATLAS_FILE)) {
+        CloseWindow();
+        return 1;
     }
-
-    if(IsKeyPressed(KEY_X)) {
-        panel_cursor_swap(panel);
+    Panel layout = {0};
+    layout_panel(&layout, GetScreenHeight());
+    PanelCache panelCache;
+    panel_cache_init(&panelCache, layout.size.x, layout.size.y);
+
+    BeamBot beamBot;
+    MctsBot mctsBot;
+    if(useBeamBot) {
+        beam_bot_init(&beamBot, beamConfig);
+        game.beamBot = &beamBot;
+    }
+    if(useMctsBot) {
+        mcts_bot_init(&mctsBot, MCTS_BOT_DEFAULT_CONFIG);
+        game.mctsBot = &mctsBot;
     }
-}
-
-int main(void) {
-    InitWindow(1280, 720, "C Tetris Attack");
-    SetTargetFPS(60);
-
-    Panel panel = {
-        .pos = {0, 0},
-        .size = {360, 720}
-    };
-
-    srand(time(NULL));
-
-    blocks = LoadTexture(BLOCKS_SPRITESHEET_FILE);
 
-    for(int i = 11; i > 5; i--) {
-        for(int j = 0; j < PANEL_NUM_OF_COLS; j++) {
-            panel.blocks[i][j].type = rand() % 6 + 1;
-            panel.blocks[i][j].currentY = i;
-            panel.blocks[i][j].col = j;
-            panel.blocks[i][j].row = i;
-        }
+    // the keys go straight to the simulation, not only when a frame checks them
+    bool playerInput = !useBeamBot && !useMctsBot && replayPath == NULL;
+    if(playerInput) keyboard_listen(&game.inputs);
+    game.measureLatency = playerInput && showLatency;
+    InputLatency latency = {0};
+
+    // the render thread has a snapshot to draw before the first tick
+    game_publish(&game);
+
+    pthread_t simulation;
+    if(pthread_create(&simulation, NULL, simulation_thread, &game) != 0) {
+        log_error("%s", "Couldn't start the simulation thread");
+        if(playerInput) keyboard_stop();
+        if(useBeamBot) beam_bot_free(&beamBot);
+        if(useMctsBot) mcts_bot_free(&mctsBot);
+        panel_cache_free(&panelCache);
+        renderer_free(&renderer);
+        CloseWindow();
+        return 1;
     }
 
     while(!WindowShouldClose()) {
-        BeginDrawing();
-        ClearBackground(BLACK);
-
-        panel_update(&panel);
-        panel_draw(&panel);
-        player_controller(&panel);
+        double deadline = pacer_next_deadline(&pacer);
+        sleep_until_seconds(pacer_start_time(&pacer));
+        double frameStart = now_seconds();
 
-        float dt = GetFrameTime();
+        // late latch: the keys pressed until now go to the queue and the ticks that
+        // will be on screen by the deadline run with them
+        PollInputEvents();
+        game_run_until(&game, deadline, pacer_draw_limit(&pacer));
+        double drawStart = now_seconds();
 
-        // the animation is kinds ugly, but it works for now
-        for(size_t i = 0; i < panel.combos.count; i++) {
-            Combo *combo = &panel.combos.items[i];
-            combo->time += dt;
+        GameSnapshot *snapshot = triple_buffer_read(&game.snapshots);
+        // the snapshot isn't changed, the panel is laid out on a copy
+        Panel panel = snapshot->panel;
+        layout_panel(&panel, GetScreenHeight());
 
-            if(combo->time >= (float)combo->count * PANEL_POP_BLOCK_DURATION + PANEL_POP_IDLE_DURATION) {
-                for(size_t i = 0; i < combo->count; i++) {
-                    PanelBlock *block = combo->items[i];
-                    *block = (PanelBlock){0};
-                }
+        BeginDrawing();
 
-                da_free(combo);
-                da_remove_unordered(&panel.combos, i);
+        // the frame's stats only measure the drawing, not the simulation
+        renderer_begin_frame(&renderer);
+        ClearBackground(BLACK);
+        render_panel(&renderer, &panelCache, &panel);
 
-                if(i > 0) i--;
-            }
+        if(puzzlePath != NULL) {
+            puzzle_mode_draw(&snapshot->puzzleMode, &panel);
+            game_puzzle_keys(&game, &snapshot->puzzleMode);
         }
 
-        int blockWidth = panel.size.x / PANEL_NUM_OF_COLS;
-        int blockHeight = panel.size.y / PANEL_NUM_OF_ROWS;
+        if(showRenderStats) render_stats(&renderer, panel.pos.x + panel.size.x + 40, panel.size.y - 40);
+        renderer_end_frame(&renderer);
+        if(showLatency) input_latency_draw(&latency, panel.pos.x + panel.size.x + 40, panel.size.y - 120);
+        if(showRenderStats) {
+            DrawText(TextFormat("%.2f ms budget, %llu frames late", pacer_budget(&pacer) * 1000,
+                (unsigned long long)pacer.missed), panel.pos.x + panel.size.x + 40, panel.size.y - 160, 20, GREEN);
+        }
 
-        for(size_t i = 0; i < panel.combos.count; i++) {
-            Combo combo = panel.combos.items[i];
+        // without a target FPS EndDrawing only swaps and polls the input. Most drivers
+        // queue the swap and return right away, glFinish waits until it's done (at the
+        // vblank with vsync) so the pacer follows the display and the wait isn't
+        // counted in the next frame's drawing
+        double swapStart = now_seconds();
+        EndDrawing();
+        glFinish();
+        double presented = now_seconds();
 
-            for(size_t j = 0; j < combo.count; j++) {
-                if(combo.time > ((float)j + 1) * PANEL_POP_BLOCK_DURATION + PANEL_POP_IDLE_DURATION)
-                    continue;
+        if(puzzlePath != NULL) game_puzzle_keys(&game, &snapshot->puzzleMode);
+        pacer_frame_done(&pacer, frameStart, drawStart, swapStart, presented);
+        if(game.measureLatency) input_latency_frame(&latency, &game.applied, snapshot->tick, presented);
+    }
 
-                PanelBlock *block = combo.items[j];
-                int posX = panel.pos.x + blockWidth * block->col;
-                int posY = panel.pos.y + blockHeight * block->row;
+    game_stop(&game);
+    pthread_join(simulation, NULL);
+    if(playerInput) keyboard_stop();
+    if(game.measureLatency) input_latency_print(&latency);
+
+    if(showRenderStats) {
+        RenderStats *stats = &renderer.stats;
+        printf("%llu frames, %.1f draw calls and %.3f ms of CPU per frame\n", (unsigned long long)stats->frames,
+            (double)stats->totalDrawCalls / stats->frames, stats->totalCpuTime / stats->frames * 1000);
+        printf("%llu frames presented late, %.2f ms budget at the end\n", (unsigned long long)pacer.missed,
+            pacer_budget(&pacer) * 1000);
+    }
 
-                draw_combo_block(block, posX, posY, 60, 60);
-            }
-        }
+    panel_cache_free(&panelCache);
+    renderer_free(&renderer);
+    CloseWindow();
 
-        EndDrawing();
+    if(game.hashLog != NULL) fclose(game.hashLog);
+    if(exportPath != NULL && !trajectory_writer_close(&exporter)) {
+        log_error("Couldn't write \"%s\"", exportPath);
+        return 1;
     }
+    if(recordPath != NULL && replayPath == NULL && !replay_save(&replay, recordPath)) return 1;
 
-    CloseWindow();
+    replay_free(&replay);
+    da_free(&puzzleMode.puzzles);
+    if(useBeamBot) beam_bot_free(&beamBot);
+    if(useMctsBot) mcts_bot_free(&mctsBot);
 
     return 0;
 }
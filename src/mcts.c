@@ -0,0 +1,218 @@
+#include <math.h>
+
+#include "mcts.h"
+#include "bot.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+#define MCTS_TREE_CAPACITY (1 << 16)
+// the playouts of a search are split in tasks of this size so idle workers can steal them
+#define MCTS_PLAYOUTS_PER_TASK 32
+// the blocks a playout has to clear to get the max reward
+#define MCTS_REWARD_BLOCKS 9.0
+
+void mcts_bot_init(MctsBot *bot, MctsBotConfig config) {
+    *bot = (MctsBot){0};
+    bot->config = config;
+    bot->target = -1;
+    bot->pool = threadpool_create(config.threads);
+
+    bot->trees = calloc(bot->pool->numWorkers, sizeof(MctsTree));
+    assert(bot->trees != NULL && "Not enough memory");
+
+    for(int i = 0; i < bot->pool->numWorkers; i++) {
+        MctsTree *tree = &bot->trees[i];
+        tree->capacity = MCTS_TREE_CAPACITY;
+        tree->nodes = malloc(sizeof(MctsNode) * tree->capacity);
+        assert(tree->nodes != NULL && "Not enough memory");
+
+        // every worker has its own sequence of random numbers, the seed is hashed
+        // with the worker so the sequences aren't shifted copies of the first one
+        uint64_t mixed = config.seed ^ (uint64_t)i;
+        tree->rng = splitmix64_next(&mixed);
+    }
+}
+
+void mcts_bot_free(MctsBot *bot) {
+    for(int i = 0; i < bot->pool->numWorkers; i++) {
+        free(bot->trees[i].nodes);
+    }
+    free(bot->trees);
+
+    threadpool_destroy(bot->pool);
+}
+
+// returns a random set bit of the mask
+static int random_bit(uint64_t *rng, uint64_t mask) {
+    int n = splitmix64_next(rng) % __builtin_popcountll(mask);
+    while(n-- > 0) mask &= mask - 1;
+    return __builtin_ctzll(mask);
+}
+
+static int add_node(MctsTree *tree, int parent, int swap, uint64_t untried) {
+    int index = tree->count++;
+    tree->nodes[index] = (MctsNode){
+        .swap = swap,
+        .parent = parent,
+        .firstChild = -1,
+        .nextSibling = -1,
+        .untried = untried,
+    };
+
+    if(parent >= 0) {
+        tree->nodes[index].nextSibling = tree->nodes[parent].firstChild;
+        tree->nodes[parent].firstChild = index;
+    }
+
+    return index;
+}
+
+static int select_child(MctsTree *tree, int node, float exploration) {
+    float logVisits = logf(tree->nodes[node].visits);
+    int best = -1;
+    float bestValue = -INFINITY;
+
+    for(int child = tree->nodes[node].firstChild; child >= 0; child = tree->nodes[child].nextSibling) {
+        MctsNode *c = &tree->nodes[child];
+        float value = c->reward / c->visits + exploration * sqrtf(logVisits / c->visits);
+        if(value > bestValue) {
+            best = child;
+            bestValue = value;
+        }
+    }
+
+    return best;
+}
+
+// the blocks that are cleared or about to be, which is what the playouts try to increase
+static int panel_progress(Panel *panel) {
+    int blocks = panel->clearedBlocks;
+    for(size_t i = 0; i < panel->combos.count; i++) {
+        blocks += panel->combos.items[i].count;
+    }
+    return blocks;
+}
+
+static void playout(MctsBot *bot, MctsTree *tree) {
+    MctsBotConfig *config = &bot->config;
+    Panel panel = bot->root;
+    uint64_t ticks = 0;
+    int node = 0;
+    int depth = 0;
+
+    // selection, going down through the nodes that have every child expanded
+    while(tree->nodes[node].untried == 0 && tree->nodes[node].firstChild >= 0 && depth < config->treeDepth) {
+        node = select_child(tree, node, config->exploration);
+        ticks += bot_simulate_swap(&panel, tree->nodes[node].swap, config->settleTicks);
+        depth++;
+    }
+
+    // expansion
+    if(tree->nodes[node].untried != 0 && depth < config->treeDepth && tree->count < tree->capacity) {
+        int swap = random_bit(&tree->rng, tree->nodes[node].untried);
+        tree->nodes[node].untried &= ~((uint64_t)1 << swap);
+
+        ticks += bot_simulate_swap(&panel, swap, config->settleTicks);
+        node = add_node(tree, node, swap, panel_legal_swaps(&panel));
+        depth++;
+    }
+
+    // simulation with random swaps
+    for(int i = 0; i < config->playoutSwaps; i++) {
+        uint64_t legal = panel_legal_swaps(&panel);
+        if(legal == 0) break;
+        ticks += bot_simulate_swap(&panel, random_bit(&tree->rng, legal), config->settleTicks);
+    }
+
+    float reward = (panel_progress(&panel) - panel_progress(&bot->root)) / MCTS_REWARD_BLOCKS;
+    if(reward > 1) reward = 1;
+
+    // backpropagation
+    for(; node >= 0; node = tree->nodes[node].parent) {
+        tree->nodes[node].visits++;
+        tree->nodes[node].reward += reward;
+    }
+
+    tree->playouts++;
+    atomic_fetch_add_explicit(&bot->simulatedTicks, ticks, memory_order_relaxed);
+}
+
+static void playouts_task(void *arg, int worker) {
+    MctsBot *bot = arg;
+    MctsTree *tree = &bot->trees[worker];
+    double start = now_seconds();
+
+    for(int i = 0; i < MCTS_PLAYOUTS_PER_TASK; i++) {
+        if(atomic_fetch_sub_explicit(&bot->remainingPlayouts, 1, memory_order_relaxed) <= 0) break;
+        if(bot->config.timeBudget > 0 && now_seconds() >= bot->deadline) break;
+
+        playout(bot, tree);
+    }
+
+    tree->busyTime += now_seconds() - start;
+}
+
+static void search(MctsBot *bot, Panel *panel) {
+    double start = now_seconds();
+    int numWorkers = bot->pool->numWorkers;
+
+    bot->root = *panel;
+    bot->deadline = start + bot->config.timeBudget;
+    atomic_store(&bot->remainingPlayouts, bot->config.maxPlayouts);
+    atomic_store(&bot->simulatedTicks, 0);
+
+    uint64_t rootSwaps = panel_legal_swaps(panel);
+    uint64_t playouts = 0;
+    double workerTime = 0;
+
+    for(int i = 0; i < numWorkers; i++) {
+        bot->trees[i].count = 0;
+        add_node(&bot->trees[i], -1, -1, rootSwaps);
+
+        playouts -= bot->trees[i].playouts;
+        workerTime -= bot->trees[i].busyTime;
+    }
+
+    int tasks = (bot->config.maxPlayouts + MCTS_PLAYOUTS_PER_TASK - 1) / MCTS_PLAYOUTS_PER_TASK;
+    for(int i = 0; i < tasks; i++) {
+        threadpool_submit(bot->pool, playouts_task, bot);
+    }
+    threadpool_wait(bot->pool);
+
+    // merge the root children of every tree, the most visited swap is the most promising
+    uint32_t visits[PANEL_NUM_OF_SWAPS] = {0};
+    float rewards[PANEL_NUM_OF_SWAPS] = {0};
+
+    for(int i = 0; i < numWorkers; i++) {
+        MctsTree *tree = &bot->trees[i];
+        for(int child = tree->nodes[0].firstChild; child >= 0; child = tree->nodes[child].nextSibling) {
+            visits[tree->nodes[child].swap] += tree->nodes[child].visits;
+            rewards[tree->nodes[child].swap] += tree->nodes[child].reward;
+        }
+
+        playouts += tree->playouts;
+        workerTime += tree->busyTime;
+    }
+
+    // a swap that never led to clearing blocks isn't worth doing
+    bot->target = -1;
+    for(int swap = 0; swap < PANEL_NUM_OF_SWAPS; swap++) {
+        if(rewards[swap] <= 0) continue;
+        if(bot->target < 0 || visits[swap] > visits[bot->target]) bot->target = swap;
+    }
+
+    bot->stats.searches++;
+    bot->stats.playouts += playouts;
+    bot->stats.workerTime += workerTime;
+    bot->stats.simulatedTicks += atomic_load(&bot->simulatedTicks);
+    bot->stats.searchTime += now_seconds() - start;
+}
+
+uint8_t mcts_bot_input(MctsBot *bot, Panel *panel) {
+    if(bot->target < 0) {
+        search(bot, panel);
+        if(bot->target < 0) return 0;
+    }
+
+    return bot_walk_to_swap(panel, &bot->target);
+}
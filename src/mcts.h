@@ -0,0 +1,81 @@
+#ifndef MCTS_H
+#define MCTS_H
+
+#include "panel.h"
+#include "threadpool.h"
+
+typedef struct {
+    int threads;        // workers of the pool, 0 uses every core
+    int maxPlayouts;    // playouts of every search
+    double timeBudget;  // seconds a search can take, 0 means only maxPlayouts is used
+    int treeDepth;      // swaps the tree can grow before the playouts take over
+    int playoutSwaps;   // random swaps done by every playout
+    int settleTicks;    // max ticks simulated after a swap waiting for the blocks to land
+    float exploration;  // UCT exploration constant
+    uint64_t seed;      // seed of the workers' RNG
+} MctsBotConfig;
+
+#define MCTS_BOT_DEFAULT_CONFIG ((MctsBotConfig){ \
+    .threads = 0,                                \
+    .maxPlayouts = 512,                          \
+    .timeBudget = 0.008,                         \
+    .treeDepth = 3,                              \
+    .playoutSwaps = 3,                           \
+    .settleTicks = 24,                           \
+    .exploration = 1.4,                          \
+    .seed = 1,                                   \
+})
+
+typedef struct {
+    int swap; // the swap that leads to this node from its parent
+    int parent;
+    int firstChild;
+    int nextSibling;
+    uint64_t untried; // legal swaps that don't have a child yet
+    uint32_t visits;
+    float reward; // sum of the rewards of every playout that went through this node
+} MctsNode;
+
+// every worker has its own tree, RNG and panel copies so they never share
+// anything while searching (root parallelization), the trees are merged at the end
+typedef struct {
+    MctsNode *nodes;
+    int count;
+    int capacity;
+    uint64_t rng;
+
+    uint64_t playouts;
+    double busyTime;
+} MctsTree;
+
+typedef struct {
+    uint64_t searches;
+    uint64_t playouts;
+    uint64_t simulatedTicks;
+    double searchTime;  // wall time of the searches
+    double workerTime;  // time the workers spent doing playouts (all of them added)
+} MctsStats;
+
+typedef struct {
+    MctsBotConfig config;
+    MctsStats stats;
+    ThreadPool *pool;
+    MctsTree *trees; // one per worker
+
+    // the swap the bot is moving the cursor to, -1 when it needs to search
+    int target;
+
+    // the state of the running search, read by the tasks
+    Panel root;
+    double deadline;
+    atomic_int remainingPlayouts;
+    atomic_uint_fast64_t simulatedTicks;
+} MctsBot;
+
+void mcts_bot_init(MctsBot *bot, MctsBotConfig config);
+void mcts_bot_free(MctsBot *bot);
+
+// returns the PanelInput flags the bot wants to press this tick (see beam_bot_input)
+uint8_t mcts_bot_input(MctsBot *bot, Panel *panel);
+
+#endif // MCTS_H
@@ -0,0 +1,67 @@
+#include <stdbool.h>
+
+#include "pacer.h"
+#include "panel.h"
+#include "timer.h"
+
+void pacer_init(FramePacer *pacer, int refreshRate) {
+    *pacer = (FramePacer){0};
+    pacer->period = 1.0 / (refreshRate > 0 ? refreshRate : 60);
+    pacer->margin = PACER_MIN_MARGIN;
+}
+
+static double slowest(const double *costs) {
+    double max = 0;
+    for(int i = 0; i < PACER_HISTORY; i++) max = MAX(max, costs[i]);
+    return max;
+}
+
+double pacer_next_deadline(FramePacer *pacer) {
+    double now = now_seconds();
+    if(pacer->vblank == 0) {
+        pacer->deadline = now;
+        return pacer->deadline;
+    }
+
+    // a deadline that can't be made anymore is skipped
+    pacer->deadline = pacer->vblank + pacer->period;
+    while(pacer->deadline < now + slowest(pacer->drawCosts)) pacer->deadline += pacer->period;
+    return pacer->deadline;
+}
+
+double pacer_budget(FramePacer *pacer) {
+    return slowest(pacer->waitCosts) + slowest(pacer->drawCosts) + pacer->margin;
+}
+
+double pacer_start_time(FramePacer *pacer) {
+    return pacer->deadline - pacer_budget(pacer);
+}
+
+double pacer_draw_limit(FramePacer *pacer) {
+    return pacer->deadline - slowest(pacer->drawCosts) - pacer->margin;
+}
+
+void pacer_frame_done(FramePacer *pacer, double start, double drawStart, double swapStart, double presented) {
+    pacer->waitCosts[pacer->nextCost] = drawStart - start;
+    pacer->drawCosts[pacer->nextCost] = swapStart - drawStart;
+    pacer->nextCost = (pacer->nextCost + 1) % PACER_HISTORY;
+
+    // late frames make the margin grow fast, it goes back slowly while they're on time
+    bool late = presented > pacer->deadline + pacer->period / 2;
+    if(pacer->vblank != 0 && late) {
+        pacer->missed++;
+        pacer->margin = MIN(pacer->margin * 2, pacer->period / 2);
+    } else {
+        pacer->margin = MAX(pacer->margin * 0.99, PACER_MIN_MARGIN);
+    }
+
+    // on time the deadline was the vblank, only nudged towards when the swap returned
+    // so a late wake up doesn't move the next deadlines (but a display that isn't
+    // exactly at its rate is followed). A late frame starts over from its swap
+    if(pacer->vblank == 0 || late || presented < pacer->deadline - pacer->period / 2) {
+        pacer->vblank = presented;
+    } else {
+        pacer->vblank = pacer->deadline + (presented - pacer->deadline) * 0.1;
+    }
+    pacer->frames++;
+}
@@ -0,0 +1,44 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <stdint.h>
+
+// paces the frames against the display instead of sleeping after every frame: a
+// frame starts as late as it can and still be presented on the next vblank, so
+// the input read at its start is as fresh as possible. With vsync a glFinish after
+// the swap returns at the vblank, the deadlines are counted from there (smoothed,
+// since it doesn't return exactly at the vblank).
+// The time a frame needs is measured in two parts, waiting for the simulation and
+// drawing, and the start is moved to fit the slowest frames of the last
+// PACER_HISTORY plus a margin that grows every time a frame is late
+#define PACER_HISTORY 60
+#define PACER_MIN_MARGIN 0.001
+
+typedef struct {
+    double period;      // of the display
+    double deadline;    // the vblank of the frame being made
+    double vblank;      // the last one, 0 before the first swap
+    double margin;
+
+    double waitCosts[PACER_HISTORY]; // from the start of the frame until it starts drawing
+    double drawCosts[PACER_HISTORY]; // from there until the swap
+    int nextCost;
+
+    uint64_t frames;
+    uint64_t missed; // frames presented a vblank (or more) after their deadline
+} FramePacer;
+
+void pacer_init(FramePacer *pacer, int refreshRate);
+
+// the vblank the next frame is for, the functions below use it
+double pacer_next_deadline(FramePacer *pacer);
+// when the frame has to start
+double pacer_start_time(FramePacer *pacer);
+// the latest the frame can start drawing
+double pacer_draw_limit(FramePacer *pacer);
+// what the whole frame is given, the time between its start and the deadline
+double pacer_budget(FramePacer *pacer);
+
+void pacer_frame_done(FramePacer *pacer, double start, double drawStart, double swapStart, double presented);
+
+#endif // PACER_H
@@ -0,0 +1,453 @@
+#include "panel.h"
+#include "CCFuncs.h"
+
+struct {
+    // random key for every block type on every position (PANEL_BLOCK_NONE is always 0)
+    uint64_t blocks[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS][PANEL_NUM_OF_BLOCK_TYPES];
+    // the cursor covers 2 blocks so it can't be on the last column
+    uint64_t cursor[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS - 1];
+} zobrist;
+
+uint64_t splitmix64_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void zobrist_init(void) {
+    uint64_t state = ZOBRIST_SEED;
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            zobrist.blocks[row][col][PANEL_BLOCK_NONE] = 0;
+
+            for(int t = PANEL_BLOCK_YELLOW; t <= PANEL_BLOCK_DARK_BLUE; t++) {
+                zobrist.blocks[row][col][t] = splitmix64_next(&state);
+            }
+        }
+
+        for(int col = 0; col < PANEL_NUM_OF_COLS - 1; col++) {
+            zobrist.cursor[row][col] = splitmix64_next(&state);
+        }
+    }
+}
+
+PanelBlock *get_block(Panel *panel, int row, int col) {
+    return &panel->blocks[row][col];
+}
+
+PanelBlock *get_combo_block(Panel *panel, Combo *combo, size_t i) {
+    int cell = combo->cells[i];
+    return get_block(panel, cell / PANEL_NUM_OF_COLS, cell % PANEL_NUM_OF_COLS);
+}
+
+// adds or removes (xor is its own inverse) the block at the given position from the hash
+static void panel_hash_block(Panel *panel, int row, int col) {
+    panel->hash ^= zobrist.blocks[row][col][panel->blocks[row][col].type];
+}
+
+static void panel_hash_cursor(Panel *panel) {
+    panel->hash ^= zobrist.cursor[panel->cursor.y][panel->cursor.x];
+}
+
+// calculates the hash from scratch, only needed when the panel is created
+uint64_t panel_compute_hash(Panel *panel) {
+    uint64_t hash = zobrist.cursor[panel->cursor.y][panel->cursor.x];
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            hash ^= zobrist.blocks[row][col][panel->blocks[row][col].type];
+        }
+    }
+
+    return hash;
+}
+
+// FNV-1a, the fields are hashed one by one so struct padding never ends up in the hash
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv_add(uint64_t hash, int64_t value) {
+    for(int i = 0; i < 8; i++) {
+        hash ^= (uint8_t)(value >> (i * 8));
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+void panel_state_hash(Panel *panel, PanelStateHash *out) {
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        uint64_t hash = FNV_OFFSET;
+
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            hash = fnv_add(hash, block->type);
+            hash = fnv_add(hash, block->currentY);
+            hash = fnv_add(hash, block->inCombo);
+            hash = fnv_add(hash, block->addedToCombo);
+            hash = fnv_add(hash, block->row);
+            hash = fnv_add(hash, block->col);
+            hash = fnv_add(hash, block->falling);
+            hash = fnv_add(hash, block->chaining);
+        }
+
+        out->rows[row] = hash;
+    }
+
+    uint64_t misc = FNV_OFFSET;
+    misc = fnv_add(misc, panel->cursor.x);
+    misc = fnv_add(misc, panel->cursor.y);
+    misc = fnv_add(misc, panel->fallingTime);
+    misc = fnv_add(misc, panel->clearedBlocks);
+    misc = fnv_add(misc, panel->chain);
+    misc = fnv_add(misc, panel->combos.count);
+
+    for(size_t i = 0; i < panel->combos.count; i++) {
+        Combo *combo = &panel->combos.items[i];
+        misc = fnv_add(misc, combo->time);
+        misc = fnv_add(misc, combo->count);
+
+        for(size_t j = 0; j < combo->count; j++) {
+            misc = fnv_add(misc, combo->cells[j]);
+        }
+    }
+    out->misc = misc;
+
+    uint64_t full = FNV_OFFSET;
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        full = fnv_add(full, out->rows[row]);
+    }
+    out->full = fnv_add(full, misc);
+}
+
+void panel_init(Panel *panel, uint64_t seed) {
+    uint64_t state = seed;
+
+    for(int i = 11; i > 5; i--) {
+        for(int j = 0; j < PANEL_NUM_OF_COLS; j++) {
+            panel->blocks[i][j].type = splitmix64_next(&state) % 6 + 1;
+            panel->blocks[i][j].currentY = i * PANEL_BLOCK_FALLING_TICKS;
+            panel->blocks[i][j].col = j;
+            panel->blocks[i][j].row = i;
+        }
+    }
+
+    panel->hash = panel_compute_hash(panel);
+}
+
+static void gravity(Panel *panel) {
+    panel->fallingTime++;
+
+    if(panel->fallingTime < PANEL_BLOCK_FALLING_TICKS) return;
+
+    panel->fallingTime = 0;
+
+    // iterate from panel bottom to top
+    // we skip the bottom row since gravity will not affect it
+    for(int row = PANEL_NUM_OF_ROWS - 2; row >= 0; row--) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            if(block->type == PANEL_BLOCK_NONE || block->inCombo) continue;
+
+            PanelBlock *botBlock = get_block(panel, row + 1, col);
+            if(botBlock->type != PANEL_BLOCK_NONE) continue;
+
+            // the bottom block is empty so only the falling block changes the hash
+            panel_hash_block(panel, row, col);
+
+            PanelBlock temp = *block;
+            *block = *botBlock;
+            *botBlock = temp;
+
+            // only change the block that is not empty
+            botBlock->row++;
+
+            panel_hash_block(panel, row + 1, col);
+        }
+    }
+}
+
+// returns true if the given block is:
+// - not outside the blocks array boundaries
+// - not part of a combo
+// - the same type as the given t
+// - is not falling
+static bool is_block_comboable(Panel *panel, int row, int col, PanelBlockType t) {
+    if(row >= PANEL_NUM_OF_ROWS || row < 0 || col >= PANEL_NUM_OF_COLS || col < 0)
+        return false;
+
+    PanelBlock b = panel->blocks[row][col];
+    return !b.addedToCombo && !b.falling && b.type == t;
+}
+
+static void block_smooth_falling(PanelBlock *block) {
+    if(block->type == PANEL_BLOCK_NONE) return;
+
+    // the falling animation takes the same ticks as the actual falling
+    if(block->currentY < block->row * PANEL_BLOCK_FALLING_TICKS) {
+        block->currentY++;
+        block->falling = true;
+    } else {
+        block->currentY = block->row * PANEL_BLOCK_FALLING_TICKS;
+        block->falling = false;
+    }
+}
+
+// Returns true if a combo was found
+static bool find_block_combo(Panel *panel, int row, int col) {
+    PanelBlock *curBlock = get_block(panel, row, col);
+    // if "addedToCombo" is true it means it's part of an existing combo
+    if(curBlock->type == PANEL_BLOCK_NONE
+        || curBlock->addedToCombo
+        || curBlock->falling) return false;
+
+    // here we check the right blocks
+    int xCount = 1;
+    while(is_block_comboable(panel, row, col + xCount, curBlock->type)) xCount++;
+
+    // and here we check the bottom blocks
+    int yCount = 1;
+    while(is_block_comboable(panel, row + yCount, col, curBlock->type)) yCount++;
+
+    bool foundCombo = false;
+
+    // here we mark the this block as part of the combo, this allows "create_combo" function
+    // to add all blocks accordingly
+    if(!curBlock->inCombo && (xCount >= 3 || yCount >= 3)) {
+        curBlock->inCombo = true;
+        foundCombo = true;
+    }
+
+    // we must set the other blocks as "inCombo" since they will not check
+    // top or left blocks
+    if(xCount >= 3) {
+        while(xCount > 1) {
+            PanelBlock *b = get_block(panel, row, col + xCount - 1);
+            b->inCombo = true;
+            xCount--;
+        }
+    }
+
+    if(yCount >= 3) {
+        while(yCount > 1) {
+            PanelBlock *b = get_block(panel, row + yCount - 1, col);
+            b->inCombo = true;
+            yCount--;
+        }
+    }
+
+    return foundCombo;
+}
+
+static void create_combo(Panel *panel) {
+    assert(panel->combos.count < PANEL_MAX_COMBOS && "There can't be more combos than PANEL_MAX_COMBOS");
+    Combo *combo = &panel->combos.items[panel->combos.count];
+    *combo = (Combo){0};
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            if(!block->inCombo || block->addedToCombo) continue;
+            block->addedToCombo = true;
+            combo->cells[combo->count++] = row * PANEL_NUM_OF_COLS + col;
+        }
+    }
+
+    assert(combo->count > 0 && "You shouldn't call this function if there's no combos available");
+    panel->combos.count++;
+
+    bool chaining = false;
+    for(size_t i = 0; i < combo->count; i++) {
+        if(get_combo_block(panel, combo, i)->chaining) chaining = true;
+    }
+
+    if(chaining) panel->chain++;
+    else if(panel->chain == 0) panel->chain = 1;
+}
+
+// the blocks above a popped block are going to fall, they can continue the chain
+static void mark_chaining_blocks(Panel *panel, int row, int col) {
+    for(int r = row - 1; r >= 0; r--) {
+        PanelBlock *block = get_block(panel, r, col);
+        // a combo that didn't pop yet holds the blocks above it
+        if(block->inCombo) break;
+        if(block->type != PANEL_BLOCK_NONE) block->chaining = true;
+    }
+}
+
+// the blocks that landed without making a combo stop being part of the chain,
+// once no block can continue the chain and nothing is popping the chain is over
+static void update_chain(Panel *panel) {
+    bool chaining = false;
+
+    for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+        // a block rests if every block below it rests too
+        bool supported = true;
+
+        for(int row = PANEL_NUM_OF_ROWS - 1; row >= 0; row--) {
+            PanelBlock *block = get_block(panel, row, col);
+            supported = supported && block->type != PANEL_BLOCK_NONE && !block->falling;
+
+            if(block->chaining && supported && !block->inCombo) block->chaining = false;
+            if(block->chaining) chaining = true;
+        }
+    }
+
+    if(!chaining && panel->combos.count == 0) panel->chain = 0;
+}
+
+// advances the combos life time and removes the ones that finished popping
+static void update_combos(Panel *panel) {
+    // iterate backwards since removing a combo moves the last one to its place
+    for(size_t i = panel->combos.count; i-- > 0;) {
+        Combo *combo = &panel->combos.items[i];
+        combo->time++;
+
+        if(combo->time < (int)combo->count * PANEL_POP_BLOCK_TICKS + PANEL_POP_IDLE_TICKS) continue;
+
+        for(size_t j = 0; j < combo->count; j++) {
+            PanelBlock *block = get_combo_block(panel, combo, j);
+            int row = block->row;
+            int col = block->col;
+            panel_hash_block(panel, row, col);
+            *block = (PanelBlock){0};
+            mark_chaining_blocks(panel, row, col);
+        }
+
+        panel->clearedBlocks += combo->count;
+        da_remove_unordered(&panel->combos, i);
+    }
+}
+
+void panel_update(Panel *panel) {
+    gravity(panel);
+
+    // every block must finish falling before looking for combos, otherwise the
+    // result would depend on the order the blocks are visited
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            block_smooth_falling(get_block(panel, row, col));
+        }
+    }
+
+    bool foundCombo = false;
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            if(find_block_combo(panel, row, col)) foundCombo = true;
+        }
+    }
+
+    if(foundCombo) create_combo(panel);
+
+    // before the combos pop, so the chain still counts on the tick its last combo pops
+    update_chain(panel);
+    update_combos(panel);
+
+#ifdef DEBUG
+    assert(panel->hash == panel_compute_hash(panel) && "The incremental hash is out of sync");
+#endif
+}
+
+bool panel_has_falling_blocks(Panel *panel) {
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            if(block->type == PANEL_BLOCK_NONE) continue;
+            if(block->falling) return true;
+
+            // the block will fall on the next gravity tick
+            bool floating = row < PANEL_NUM_OF_ROWS - 1 && !block->inCombo
+                && panel->blocks[row + 1][col].type == PANEL_BLOCK_NONE;
+            if(floating) return true;
+        }
+    }
+
+    return false;
+}
+
+// a block can't be swapped while it's part of a combo or while it's falling
+static bool is_block_locked(PanelBlock *block) {
+    return block->inCombo || block->falling;
+}
+
+void panel_swap(Panel *panel, int row, int col) {
+    PanelBlock *left = get_block(panel, row, col);
+    if(is_block_locked(left)) return;
+    PanelBlock *right = get_block(panel, row, col + 1);
+    if(is_block_locked(right)) return;
+
+    panel_hash_block(panel, row, col);
+    panel_hash_block(panel, row, col + 1);
+
+    PanelBlock temp = *left;
+
+    *left = *right;
+    *right = temp;
+
+    if(right->type != PANEL_BLOCK_NONE) right->col++;
+    if(left->type != PANEL_BLOCK_NONE) left->col--;
+
+    panel_hash_block(panel, row, col);
+    panel_hash_block(panel, row, col + 1);
+}
+
+void panel_cursor_swap(Panel *panel) {
+    panel_swap(panel, panel->cursor.y, panel->cursor.x);
+}
+
+uint64_t panel_legal_swaps(Panel *panel) {
+    uint64_t swaps = 0;
+    // a swap covers the block on its column and the one on its right
+    const uint64_t rowSwaps = (1 << PANEL_SWAPS_PER_ROW) - 1;
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        // one bit per column
+        uint64_t locked = 0;
+        // one bit per swap, set when both blocks are the same (including two empty cells)
+        uint64_t same = 0;
+
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            locked |= (uint64_t)is_block_locked(block) << col;
+
+            if(col > 0) same |= (uint64_t)(block->type == block[-1].type) << (col - 1);
+        }
+
+        // shifting by one puts the right block of every swap on the swap's bit,
+        // swapping two equal blocks does nothing so it's not a move
+        uint64_t legal = ~(locked | locked >> 1) & ~same & rowSwaps;
+        swaps |= legal << (row * PANEL_SWAPS_PER_ROW);
+    }
+
+    return swaps;
+}
+
+void panel_cursor_move(Panel *panel, int x, int y) {
+    panel_hash_cursor(panel);
+
+    // here we substract by 2 because the cursor's length is 2 blocks
+    panel->cursor.x = MAX(MIN(x, PANEL_NUM_OF_COLS - 2), 0);
+    panel->cursor.y = MAX(MIN(y, PANEL_NUM_OF_ROWS - 1), 0);
+
+    panel_hash_cursor(panel);
+}
+
+void panel_apply_input(Panel *panel, uint8_t input) {
+    if(input & PANEL_INPUT_RIGHT) {
+        panel_cursor_move(panel, panel->cursor.x + 1, panel->cursor.y);
+    } else if(input & PANEL_INPUT_LEFT) {
+        panel_cursor_move(panel, panel->cursor.x - 1, panel->cursor.y);
+    }
+
+    if(input & PANEL_INPUT_DOWN) {
+        panel_cursor_move(panel, panel->cursor.x, panel->cursor.y + 1);
+    } else if(input & PANEL_INPUT_UP) {
+        panel_cursor_move(panel, panel->cursor.x, panel->cursor.y - 1);
+    }
+
+    if(input & PANEL_INPUT_SWAP) {
+        panel_cursor_swap(panel);
+    }
+}
@@ -0,0 +1,154 @@
+#ifndef PANEL_H
+#define PANEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// how many columns per row should contain a panel
+#define PANEL_NUM_OF_COLS 6
+#define PANEL_NUM_OF_ROWS 12
+#define PANEL_NUM_OF_CELLS (PANEL_NUM_OF_ROWS * PANEL_NUM_OF_COLS)
+
+// a combo has at least 3 blocks so there can't be more combos than this at the same time
+#define PANEL_MAX_COMBOS (PANEL_NUM_OF_CELLS / 3)
+
+// the simulation runs on fixed ticks (no floats involved) so it gives the same
+// result on every machine and build
+#define PANEL_TICKS_PER_SECOND 60
+#define PANEL_TICK_TIME (1.0 / PANEL_TICKS_PER_SECOND)
+
+// the ticks that need to be waited to make the blocks fall (0.05s)
+#define PANEL_BLOCK_FALLING_TICKS 3
+
+ // the ticks we need to wait before starting to pop the combo's block (0.5s)
+#define PANEL_POP_IDLE_TICKS 30
+// the duration of each block pop (0.1s)
+#define PANEL_POP_BLOCK_TICKS 6
+
+// seed used to generate the zobrist keys, it must never change since the hashes
+// should be the same across runs and builds
+#define ZOBRIST_SEED 0x7e7215a77ac6ULL
+
+#define MIN(a, b) ((a) > (b) ? (b) : (a))
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+
+typedef enum {
+    PANEL_BLOCK_NONE = 0,
+    PANEL_BLOCK_YELLOW,
+    PANEL_BLOCK_RED,
+    PANEL_BLOCK_PURPLE,
+    PANEL_BLOCK_GREEN,
+    PANEL_BLOCK_BLUE,
+    PANEL_BLOCK_DARK_BLUE,
+} PanelBlockType;
+
+#define PANEL_NUM_OF_BLOCK_TYPES (PANEL_BLOCK_DARK_BLUE + 1)
+
+// the possible swaps of a row, the last column can't be the left side of a swap
+#define PANEL_SWAPS_PER_ROW (PANEL_NUM_OF_COLS - 1)
+#define PANEL_NUM_OF_SWAPS (PANEL_NUM_OF_ROWS * PANEL_SWAPS_PER_ROW)
+// the bit of a swap in the mask returned by panel_legal_swaps
+#define PANEL_SWAP_BIT(row, col) ((uint64_t)1 << ((row) * PANEL_SWAPS_PER_ROW + (col)))
+
+// the inputs the panel understands, they're bit flags so a whole tick of input fits in a byte
+typedef enum {
+    PANEL_INPUT_LEFT  = 1 << 0,
+    PANEL_INPUT_RIGHT = 1 << 1,
+    PANEL_INPUT_UP    = 1 << 2,
+    PANEL_INPUT_DOWN  = 1 << 3,
+    PANEL_INPUT_SWAP  = 1 << 4,
+} PanelInput;
+
+typedef struct {
+    PanelBlockType type;
+    // used to fall smoothly, it's measured in falling ticks (row * PANEL_BLOCK_FALLING_TICKS)
+    int currentY;
+    bool inCombo;
+    bool addedToCombo; // used to avoid creating new combos
+
+    // the actual position on the matrix
+    int row;
+    int col;
+
+    bool falling;
+    // the block is falling because a combo below it popped, if it makes a combo
+    // when it lands the chain goes on
+    bool chaining;
+} PanelBlock;
+
+typedef struct {
+    // All the blocks positions (row * PANEL_NUM_OF_COLS + col) that conform a combo,
+    // positions are used instead of pointers so a panel can be copied with a plain assignment
+    uint8_t cells[PANEL_NUM_OF_CELLS];
+    size_t count;
+    int time; // life time of the combo since its creation in ticks
+} Combo;
+
+typedef struct {
+    struct { float x, y; } pos;
+    struct { float x, y; } size;
+    PanelBlock blocks[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS];
+
+    struct {
+        int x; int y;
+    } cursor;
+
+    int fallingTime; // used to count when the block should fall
+
+    struct {
+        Combo items[PANEL_MAX_COMBOS];
+        size_t count;
+    } combos;
+
+    // blocks popped since the panel was created
+    uint32_t clearedBlocks;
+    // links of the running chain: 1 for a combo, 2 when a block that fell after it
+    // makes another combo and so on. 0 once nothing is popping or falling from a combo
+    int chain;
+
+    // zobrist hash of the block types and the cursor, it's updated every time
+    // one of them changes so it never needs to be recalculated
+    uint64_t hash;
+} Panel;
+
+// hash of everything the simulation depends on, split by rows so two diverging
+// simulations can tell where they differ and not only when
+typedef struct {
+    uint64_t rows[PANEL_NUM_OF_ROWS];
+    uint64_t misc; // cursor, falling time, combos, chain and cleared blocks
+    uint64_t full; // the combination of all the above
+} PanelStateHash;
+
+// splitmix64, used instead of rand() since it gives the same numbers on every platform
+uint64_t splitmix64_next(uint64_t *state);
+
+// must be called once before creating any panel
+void zobrist_init(void);
+
+// fills the bottom half of the panel with random blocks generated from the seed
+void panel_init(Panel *panel, uint64_t seed);
+
+PanelBlock *get_block(Panel *panel, int row, int col);
+// returns the block of a Combo cell
+PanelBlock *get_combo_block(Panel *panel, Combo *combo, size_t i);
+
+uint64_t panel_compute_hash(Panel *panel);
+void panel_state_hash(Panel *panel, PanelStateHash *out);
+
+void panel_cursor_move(Panel *panel, int x, int y);
+// swaps the block at the given position with the one on its right
+void panel_swap(Panel *panel, int row, int col);
+void panel_cursor_swap(Panel *panel);
+// returns a mask with the PANEL_SWAP_BIT of every swap that would do something:
+// none of the blocks can be in a combo or falling and they can't be the same type
+// (swapping two equal blocks or two empty cells does nothing)
+uint64_t panel_legal_swaps(Panel *panel);
+void panel_apply_input(Panel *panel, uint8_t input);
+
+// advances the simulation by one tick
+void panel_update(Panel *panel);
+// returns true if a block is falling or is going to fall
+bool panel_has_falling_blocks(Panel *panel);
+
+#endif // PANEL_H
@@ -0,0 +1,240 @@
+#include "panel_batch.h"
+
+// comparisons between vectors give signed vectors with -1 (all bits set) on the
+// lanes where they're true, which is used as a mask
+typedef int8_t LaneI8 __attribute__((vector_size(PANEL_BATCH_LANES)));
+typedef int16_t LaneI16 __attribute__((vector_size(PANEL_BATCH_LANES * 2)));
+
+#define MASK(cond) ((LaneU8)(cond))
+
+static inline LaneU8 select_u8(LaneU8 mask, LaneU8 a, LaneU8 b) {
+    return (a & mask) | (b & ~mask);
+}
+
+// converting the signed values keeps every bit set (-1 stays -1). These are macros
+// since passing 32 byte vectors to functions depends on the target having AVX
+#define WIDEN_MASK(mask) ((LaneU16)__builtin_convertvector((LaneI8)(mask), LaneI16))
+#define NARROW_MASK(mask) ((LaneU8)__builtin_convertvector((LaneI16)(mask), LaneI8))
+
+static int combo_pop_ticks(size_t count) {
+    return count * PANEL_POP_BLOCK_TICKS + PANEL_POP_IDLE_TICKS;
+}
+
+void panel_batch_load(PanelBatch *batch, int lane, Panel *panel) {
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            bool empty = block->type == PANEL_BLOCK_NONE;
+
+            batch->type[row][col][lane] = block->type;
+            batch->flags[row][col][lane] = empty ? 0
+                : (block->inCombo ? PANEL_BATCH_IN_COMBO : 0) | (block->falling ? PANEL_BATCH_FALLING : 0);
+            batch->fallOffset[row][col][lane] = empty ? 0 : row * PANEL_BLOCK_FALLING_TICKS - block->currentY;
+            batch->popTimer[row][col][lane] = 0;
+        }
+    }
+
+    for(size_t i = 0; i < panel->combos.count; i++) {
+        Combo *combo = &panel->combos.items[i];
+
+        for(size_t j = 0; j < combo->count; j++) {
+            int cell = combo->cells[j];
+            batch->popTimer[cell / PANEL_NUM_OF_COLS][cell % PANEL_NUM_OF_COLS][lane] =
+                combo_pop_ticks(combo->count) - combo->time;
+        }
+    }
+
+    batch->fallingTime[lane] = panel->fallingTime;
+    batch->clearedBlocks[lane] = panel->clearedBlocks;
+}
+
+bool panel_batch_matches(PanelBatch *batch, int lane, Panel *panel) {
+    if(batch->fallingTime[lane] != panel->fallingTime) return false;
+    if(batch->clearedBlocks[lane] != panel->clearedBlocks) return false;
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            if(batch->type[row][col][lane] != block->type) return false;
+            if(block->type == PANEL_BLOCK_NONE) continue;
+
+            uint8_t flags = batch->flags[row][col][lane];
+            int currentY = row * PANEL_BLOCK_FALLING_TICKS - batch->fallOffset[row][col][lane];
+
+            if(block->inCombo != ((flags & PANEL_BATCH_IN_COMBO) != 0)) return false;
+            if(block->falling != ((flags & PANEL_BATCH_FALLING) != 0)) return false;
+            if(block->currentY != currentY) return false;
+        }
+    }
+
+    for(size_t i = 0; i < panel->combos.count; i++) {
+        Combo *combo = &panel->combos.items[i];
+
+        for(size_t j = 0; j < combo->count; j++) {
+            int cell = combo->cells[j];
+            int timer = batch->popTimer[cell / PANEL_NUM_OF_COLS][cell % PANEL_NUM_OF_COLS][lane];
+            if(timer != combo_pop_ticks(combo->count) - combo->time) return false;
+        }
+    }
+
+    return true;
+}
+
+static void batch_gravity(PanelBatch *batch) {
+    batch->fallingTime += 1;
+
+    LaneU8 gravityLanes = MASK(batch->fallingTime >= PANEL_BLOCK_FALLING_TICKS);
+    batch->fallingTime &= ~gravityLanes;
+
+    // same order as gravity(), from the bottom to the top so a whole column falls together
+    for(int row = PANEL_NUM_OF_ROWS - 2; row >= 0; row--) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            LaneU8 type = batch->type[row][col];
+            LaneU8 botType = batch->type[row + 1][col];
+
+            LaneU8 falls = gravityLanes
+                & MASK(type != 0)
+                & MASK((batch->flags[row][col] & PANEL_BATCH_IN_COMBO) == 0)
+                & MASK(botType == 0);
+
+            // the empty cells are always zeroed so moving the block is enough.
+            // the pop timer isn't moved since only blocks out of combos fall
+            batch->type[row + 1][col] = select_u8(falls, type, botType);
+            batch->flags[row + 1][col] = select_u8(falls, batch->flags[row][col], batch->flags[row + 1][col]);
+            batch->fallOffset[row + 1][col] = select_u8(falls,
+                batch->fallOffset[row][col] + PANEL_BLOCK_FALLING_TICKS,
+                batch->fallOffset[row + 1][col]);
+
+            batch->type[row][col] &= ~falls;
+            batch->flags[row][col] &= ~falls;
+            batch->fallOffset[row][col] &= ~falls;
+        }
+    }
+}
+
+static void batch_smooth_falling(PanelBatch *batch) {
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            LaneU8 behind = MASK(batch->type[row][col] != 0) & MASK(batch->fallOffset[row][col] != 0);
+
+            batch->fallOffset[row][col] -= behind & 1;
+            batch->flags[row][col] = (batch->flags[row][col] & ~PANEL_BATCH_FALLING) | (behind & PANEL_BATCH_FALLING);
+        }
+    }
+}
+
+// marks the blocks that form new combos and returns how many there are on every lane
+static LaneU8 batch_find_combos(PanelBatch *batch, LaneU8 combo[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS]) {
+    LaneU8 comboable[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS];
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            comboable[row][col] = MASK(batch->type[row][col] != 0)
+                & MASK((batch->flags[row][col] & (PANEL_BATCH_IN_COMBO | PANEL_BATCH_FALLING)) == 0);
+            combo[row][col] = (LaneU8){0};
+        }
+    }
+
+    // every combo of 4 or 5 blocks contains a combo of 3, so checking every group
+    // of 3 blocks finds the same blocks as find_block_combo()
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            LaneU8 (*t)[PANEL_NUM_OF_COLS] = batch->type;
+
+            if(col + 2 < PANEL_NUM_OF_COLS) {
+                LaneU8 match = comboable[row][col] & comboable[row][col + 1] & comboable[row][col + 2]
+                    & MASK(t[row][col] == t[row][col + 1]) & MASK(t[row][col] == t[row][col + 2]);
+
+                combo[row][col] |= match;
+                combo[row][col + 1] |= match;
+                combo[row][col + 2] |= match;
+            }
+
+            if(row + 2 < PANEL_NUM_OF_ROWS) {
+                LaneU8 match = comboable[row][col] & comboable[row + 1][col] & comboable[row + 2][col]
+                    & MASK(t[row][col] == t[row + 1][col]) & MASK(t[row][col] == t[row + 2][col]);
+
+                combo[row][col] |= match;
+                combo[row + 1][col] |= match;
+                combo[row + 2][col] |= match;
+            }
+        }
+    }
+
+    LaneU8 count = {0};
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            count += combo[row][col] & 1;
+        }
+    }
+
+    return count;
+}
+
+void panel_batch_update(PanelBatch *batch) {
+    batch_gravity(batch);
+    batch_smooth_falling(batch);
+
+    LaneU8 combo[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS];
+    LaneU8 count = batch_find_combos(batch, combo);
+
+    // like create_combo(), all the new blocks of a tick form a single combo
+    LaneU16 popTicks = __builtin_convertvector(count, LaneU16) * PANEL_POP_BLOCK_TICKS + PANEL_POP_IDLE_TICKS;
+    LaneU8 popped = {0};
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            LaneU16 isNew = WIDEN_MASK(combo[row][col]);
+            batch->flags[row][col] |= combo[row][col] & PANEL_BATCH_IN_COMBO;
+            batch->popTimer[row][col] = (popTicks & isNew) | (batch->popTimer[row][col] & ~isNew);
+
+            // same as update_combos()
+            LaneU16 inCombo = WIDEN_MASK(MASK((batch->flags[row][col] & PANEL_BATCH_IN_COMBO) != 0));
+            batch->popTimer[row][col] -= inCombo & 1;
+
+            LaneU8 pops = NARROW_MASK(inCombo & (LaneU16)(batch->popTimer[row][col] == 0));
+            batch->type[row][col] &= ~pops;
+            batch->flags[row][col] &= ~pops;
+            batch->fallOffset[row][col] &= ~pops;
+            popped += pops & 1;
+        }
+    }
+
+    for(int lane = 0; lane < PANEL_BATCH_LANES; lane++) {
+        batch->clearedBlocks[lane] += popped[lane];
+    }
+}
+
+static bool is_lane_block_locked(PanelBatch *batch, int lane, int row, int col) {
+    return batch->flags[row][col][lane] & (PANEL_BATCH_IN_COMBO | PANEL_BATCH_FALLING);
+}
+
+void panel_batch_swap(PanelBatch *batch, int lane, int row, int col) {
+    if(is_lane_block_locked(batch, lane, row, col)) return;
+    if(is_lane_block_locked(batch, lane, row, col + 1)) return;
+
+    // blocks out of combos have no pop timer so it doesn't need to be swapped
+    uint8_t type = batch->type[row][col][lane];
+    batch->type[row][col][lane] = batch->type[row][col + 1][lane];
+    batch->type[row][col + 1][lane] = type;
+
+    uint8_t offset = batch->fallOffset[row][col][lane];
+    batch->fallOffset[row][col][lane] = batch->fallOffset[row][col + 1][lane];
+    batch->fallOffset[row][col + 1][lane] = offset;
+}
+
+uint64_t panel_batch_legal_swaps(PanelBatch *batch, int lane) {
+    uint64_t swaps = 0;
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_SWAPS_PER_ROW; col++) {
+            bool legal = !is_lane_block_locked(batch, lane, row, col)
+                && !is_lane_block_locked(batch, lane, row, col + 1)
+                && batch->type[row][col][lane] != batch->type[row][col + 1][lane];
+
+            if(legal) swaps |= PANEL_SWAP_BIT(row, col);
+        }
+    }
+
+    return swaps;
+}
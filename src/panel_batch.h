@@ -0,0 +1,48 @@
+#ifndef PANEL_BATCH_H
+#define PANEL_BATCH_H
+
+#include "panel.h"
+
+// panels simulated together, one per lane of the vectors
+#define PANEL_BATCH_LANES 16
+
+// GCC vector extensions, the compiler turns them into SSE/AVX/NEON depending on the target
+typedef uint8_t LaneU8 __attribute__((vector_size(PANEL_BATCH_LANES)));
+typedef uint16_t LaneU16 __attribute__((vector_size(PANEL_BATCH_LANES * 2)));
+
+// the flags of a cell
+#define PANEL_BATCH_IN_COMBO 1
+#define PANEL_BATCH_FALLING  2
+
+// many independent panels following the same rules as panel_update, stored so the
+// same cell of every panel is in a single vector (structure of arrays). Every rule
+// is applied to all the panels with the same vector instructions.
+//
+// only what affects the game is kept, so the order the blocks of a combo pop in
+// (which is only used to draw them) isn't tracked
+typedef struct {
+    LaneU8 type[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS];
+    LaneU8 flags[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS];
+    // the falling ticks the block is behind its row (row * PANEL_BLOCK_FALLING_TICKS - currentY)
+    LaneU8 fallOffset[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS];
+    // ticks until the combo of the block pops, it's the same for every block of a combo
+    LaneU16 popTimer[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS];
+
+    LaneU8 fallingTime;
+    uint32_t clearedBlocks[PANEL_BATCH_LANES];
+} PanelBatch;
+
+// copies a panel into the given lane
+void panel_batch_load(PanelBatch *batch, int lane, Panel *panel);
+// returns true if the lane plays the same as the panel (empty cells and the
+// combos' pop order are ignored since they don't affect the game)
+bool panel_batch_matches(PanelBatch *batch, int lane, Panel *panel);
+
+// advances every lane by one tick, same as calling panel_update on each panel
+void panel_batch_update(PanelBatch *batch);
+
+// same as panel_swap and panel_legal_swaps for a single lane
+void panel_batch_swap(PanelBatch *batch, int lane, int row, int col);
+uint64_t panel_batch_legal_swaps(PanelBatch *batch, int lane);
+
+#endif // PANEL_BATCH_H
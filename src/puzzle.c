@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "puzzle.h"
+#include "CCFuncs.h"
+
+// the character of every PanelBlockType in the puzzle files
+static const char blockChars[PANEL_NUM_OF_BLOCK_TYPES] = { '.', 'y', 'r', 'p', 'g', 'b', 'd' };
+
+static int block_from_char(char c) {
+    for(int type = 0; type < PANEL_NUM_OF_BLOCK_TYPES; type++) {
+        if(blockChars[type] == c) return type;
+    }
+    return -1;
+}
+
+// removes the trailing new line and spaces
+static void trim_line(char *line) {
+    size_t len = strlen(line);
+    while(len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) {
+        line[--len] = '\0';
+    }
+}
+
+// moves the rows read to the bottom of the panel
+static void puzzle_align_rows(Puzzle *puzzle, int rows) {
+    int offset = PANEL_NUM_OF_ROWS - rows;
+    if(offset == 0) return;
+
+    memmove(puzzle->types[offset], puzzle->types[0], rows * PANEL_NUM_OF_COLS);
+    memset(puzzle->types[0], PANEL_BLOCK_NONE, offset * PANEL_NUM_OF_COLS);
+}
+
+void puzzle_write_binary_header(FILE *f) {
+    uint32_t version = PUZZLE_BINARY_VERSION;
+
+    fwrite(PUZZLE_BINARY_MAGIC, 1, 4, f);
+    for(int i = 0; i < 4; i++) fputc((version >> (i * 8)) & 0xff, f);
+}
+
+void puzzle_write_binary(FILE *f, Puzzle *puzzle) {
+    uint8_t bytes[PUZZLE_BINARY_SIZE] = {0};
+    bytes[0] = puzzle->swaps;
+
+    for(int cell = 0; cell < PANEL_NUM_OF_CELLS; cell++) {
+        int bit = cell * 3;
+        uint16_t type = puzzle->types[cell / PANEL_NUM_OF_COLS][cell % PANEL_NUM_OF_COLS];
+
+        // a cell can be split between two bytes
+        bytes[1 + bit / 8] |= (type << (bit % 8)) & 0xff;
+        if(bit % 8 > 5) bytes[2 + bit / 8] |= type >> (8 - bit % 8);
+    }
+
+    fwrite(bytes, 1, sizeof(bytes), f);
+}
+
+static bool puzzle_read_binary(Puzzles *puzzles, FILE *f, const char *path) {
+    uint8_t version[4];
+    if(fread(version, 1, 4, f) != 4 || version[0] != PUZZLE_BINARY_VERSION || version[1] || version[2] || version[3]) {
+        log_error("\"%s\" has an unknown version", path);
+        return false;
+    }
+
+    uint8_t bytes[PUZZLE_BINARY_SIZE];
+    size_t read;
+
+    while((read = fread(bytes, 1, sizeof(bytes), f)) == sizeof(bytes)) {
+        Puzzle puzzle = { .swaps = bytes[0] };
+        snprintf(puzzle.name, sizeof(puzzle.name), "%zu", puzzles->count + 1);
+
+        for(int cell = 0; cell < PANEL_NUM_OF_CELLS; cell++) {
+            int bit = cell * 3;
+            uint16_t packed = bytes[1 + bit / 8] | (bit % 8 > 5 ? bytes[2 + bit / 8] << 8 : 0);
+            uint8_t type = (packed >> (bit % 8)) & 7;
+
+            if(type >= PANEL_NUM_OF_BLOCK_TYPES || puzzle.swaps < 1 || puzzle.swaps > PUZZLE_MAX_SWAPS) {
+                log_error("\"%s\": puzzle %zu is not valid", path, puzzles->count + 1);
+                return false;
+            }
+            puzzle.types[cell / PANEL_NUM_OF_COLS][cell % PANEL_NUM_OF_COLS] = type;
+        }
+
+        da_append(puzzles, puzzle);
+    }
+
+    if(read != 0) {
+        log_error("\"%s\" is truncated", path);
+        return false;
+    }
+    return true;
+}
+
+bool puzzle_load_file(Puzzles *puzzles, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    char magic[4];
+    if(fread(magic, 1, 4, f) == 4 && memcmp(magic, PUZZLE_BINARY_MAGIC, 4) == 0) {
+        bool ok = puzzle_read_binary(puzzles, f, path);
+        fclose(f);
+        return ok;
+    }
+    rewind(f);
+
+    char line[256];
+    int lineNumber = 0;
+    Puzzle puzzle;
+    // rows read of the current puzzle, -1 before the first puzzle
+    int rows = -1;
+    bool ok = true;
+
+    while(ok && fgets(line, sizeof(line), f) != NULL) {
+        lineNumber++;
+        trim_line(line);
+        if(line[0] == '#' || line[0] == '\0') continue;
+
+        if(strncmp(line, "puzzle ", 7) == 0) {
+            if(rows >= 0) {
+                puzzle_align_rows(&puzzle, rows);
+                da_append(puzzles, puzzle);
+            }
+
+            puzzle = (Puzzle){0};
+            rows = 0;
+
+            char name[PUZZLE_MAX_NAME];
+            if(sscanf(line + 7, "%31s %d", name, &puzzle.swaps) != 2
+                || puzzle.swaps < 1 || puzzle.swaps > PUZZLE_MAX_SWAPS) {
+                log_error("%s:%d: expected \"puzzle <name> <1-%d swaps>\"", path, lineNumber, PUZZLE_MAX_SWAPS);
+                ok = false;
+                break;
+            }
+            strcpy(puzzle.name, name);
+            continue;
+        }
+
+        if(rows < 0 || rows >= PANEL_NUM_OF_ROWS || strlen(line) != PANEL_NUM_OF_COLS) {
+            log_error("%s:%d: expected a row of %d cells of a puzzle", path, lineNumber, PANEL_NUM_OF_COLS);
+            ok = false;
+            break;
+        }
+
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            int type = block_from_char(line[col]);
+            if(type < 0) {
+                log_error("%s:%d: unknown block '%c'", path, lineNumber, line[col]);
+                ok = false;
+                break;
+            }
+            puzzle.types[rows][col] = type;
+        }
+        rows++;
+    }
+
+    if(ok && rows >= 0) {
+        puzzle_align_rows(&puzzle, rows);
+        da_append(puzzles, puzzle);
+    }
+
+    fclose(f);
+    return ok;
+}
+
+void puzzle_write(FILE *f, Puzzle *puzzle) {
+    fprintf(f, "puzzle %s %d\n", puzzle->name, puzzle->swaps);
+
+    // the empty rows at the top are skipped since the rows are placed at the bottom
+    int row = 0;
+    while(row < PANEL_NUM_OF_ROWS - 1) {
+        bool empty = true;
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            if(puzzle->types[row][col] != PANEL_BLOCK_NONE) empty = false;
+        }
+        if(!empty) break;
+        row++;
+    }
+
+    for(; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            fputc(blockChars[puzzle->types[row][col]], f);
+        }
+        fputc('\n', f);
+    }
+    fputc('\n', f);
+}
+
+void puzzle_to_panel(Puzzle *puzzle, Panel *panel) {
+    Panel empty = { .pos = panel->pos, .size = panel->size };
+    *panel = empty;
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            block->type = puzzle->types[row][col];
+            block->currentY = row * PANEL_BLOCK_FALLING_TICKS;
+            block->row = row;
+            block->col = col;
+        }
+    }
+
+    panel->hash = panel_compute_hash(panel);
+}
+
+bool panel_is_empty(Panel *panel) {
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            if(panel->blocks[row][col].type != PANEL_BLOCK_NONE) return false;
+        }
+    }
+    return true;
+}
+
+int panel_settle(Panel *panel) {
+    int ticks = 0;
+    // at least a tick, the combos made by a swap are only found by panel_update
+    do {
+        panel_update(panel);
+        ticks++;
+    } while(ticks < PUZZLE_MAX_SETTLE_TICKS && (panel->combos.count > 0 || panel_has_falling_blocks(panel)));
+    return ticks;
+}
@@ -0,0 +1,61 @@
+#ifndef PUZZLE_H
+#define PUZZLE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "panel.h"
+
+#define PUZZLE_MAX_NAME 32
+// puzzles with more swaps than this can't be solved in a reasonable time
+#define PUZZLE_MAX_SWAPS 8
+// a board that is still moving after this many ticks is taken as settled
+#define PUZZLE_MAX_SETTLE_TICKS (PANEL_TICKS_PER_SECOND * 30)
+
+// a fixed board that has to be cleared with exactly the given swaps
+typedef struct {
+    char name[PUZZLE_MAX_NAME];
+    int swaps;
+    uint8_t types[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS]; // PanelBlockType of every cell
+} Puzzle;
+
+typedef struct {
+    Puzzle *items;
+    size_t count;
+    size_t capacity;
+} Puzzles;
+
+// the puzzle file can be a binary file (see below) or a text file with one or more puzzles:
+//
+//   # comments start with #
+//   puzzle <name> <swaps>
+//   ..r...
+//   .rgg.r
+//
+// the rows go from top to bottom and they're placed at the bottom of the panel
+// when there are less than PANEL_NUM_OF_ROWS. Every cell is one of ". y r p g b d"
+// (empty, yellow, red, purple, green, blue and dark blue)
+bool puzzle_load_file(Puzzles *puzzles, const char *path);
+// appends the puzzle to the file in the same format
+void puzzle_write(FILE *f, Puzzle *puzzle);
+
+// the binary puzzle file, for big generated sets: "TAPZ", the u32 version (little
+// endian) and then the puzzles until the end of the file. Every puzzle takes
+// PUZZLE_BINARY_SIZE bytes: the swaps and the cells packed in 3 bits each,
+// row by row. The puzzles have no name, they're named after their position
+#define PUZZLE_BINARY_MAGIC "TAPZ"
+#define PUZZLE_BINARY_VERSION 1
+#define PUZZLE_BINARY_SIZE (1 + (PANEL_NUM_OF_CELLS * 3 + 7) / 8)
+
+void puzzle_write_binary_header(FILE *f);
+void puzzle_write_binary(FILE *f, Puzzle *puzzle);
+
+// creates the panel of the puzzle, the panel's position and size are kept
+void puzzle_to_panel(Puzzle *puzzle, Panel *panel);
+
+bool panel_is_empty(Panel *panel);
+// simulates at least a tick and until nothing is falling and every combo popped,
+// returns the ticks simulated
+int panel_settle(Panel *panel);
+
+#endif // PUZZLE_H
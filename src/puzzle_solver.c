@@ -0,0 +1,157 @@
+#include "puzzle_solver.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+void puzzle_solver_init(PuzzleSolver *solver, PuzzleSolverConfig config) {
+    *solver = (PuzzleSolver){0};
+    solver->config = config;
+    // the generator runs a solver on every thread, those search on their own thread
+    if(config.threads != 1) solver->pool = threadpool_create(config.threads);
+    ttable_init(&solver->ttable, config.ttableBytes);
+}
+
+void puzzle_solver_free(PuzzleSolver *solver) {
+    if(solver->pool != NULL) threadpool_destroy(solver->pool);
+    ttable_free(&solver->ttable);
+}
+
+// the search only sees settled boards, so the block types and the falling
+// phase (when the next gravity tick happens) are everything that matters
+static uint64_t board_key(Panel *panel) {
+    uint64_t state = panel->fallingTime ^ ZOBRIST_SEED;
+    return panel->hash ^ splitmix64_next(&state);
+}
+
+// a combo clears 3 or more blocks of the same color, so a color with 1 or 2
+// blocks can never be cleared
+static bool can_be_cleared(Panel *panel) {
+    int count[PANEL_NUM_OF_BLOCK_TYPES] = {0};
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            count[panel->blocks[row][col].type]++;
+        }
+    }
+
+    for(int type = PANEL_BLOCK_NONE + 1; type < PANEL_NUM_OF_BLOCK_TYPES; type++) {
+        if(count[type] == 1 || count[type] == 2) return false;
+    }
+    return true;
+}
+
+static void do_swap(PuzzleSolver *solver, Panel *panel, int swap) {
+    panel_swap(panel, swap / PANEL_SWAPS_PER_ROW, swap % PANEL_SWAPS_PER_ROW);
+    int ticks = panel_settle(panel);
+    atomic_fetch_add_explicit(&solver->simulatedTicks, ticks, memory_order_relaxed);
+}
+
+static bool should_stop(PuzzleSolver *solver) {
+    return atomic_load_explicit(&solver->solutions, memory_order_relaxed) >= solver->config.maxSolutions;
+}
+
+// returns the solutions that clear the board with exactly "remaining" swaps. The
+// shorter ones were ruled out by the previous iterations, so a board with no
+// solution also has none with less swaps and is stored as such in the table
+static int search(PuzzleSolver *solver, PuzzleRootTask *task, Panel *panel, int remaining, int *path, int ply) {
+    atomic_fetch_add_explicit(&solver->nodes, 1, memory_order_relaxed);
+
+    if(panel_is_empty(panel)) {
+        if(remaining != 0) return 0;
+
+        if(task->solutions == 0) memcpy(task->solutionSwaps, path, sizeof(int) * ply);
+        task->solutions++;
+        atomic_fetch_add_explicit(&solver->solutions, 1, memory_order_relaxed);
+        return 1;
+    }
+
+    if(remaining == 0 || !can_be_cleared(panel)) return 0;
+
+    uint64_t key = board_key(panel);
+    TTableHit hit;
+    if(ttable_probe(&solver->ttable, key, &hit) && hit.depth >= remaining) return 0;
+
+    int solutions = 0;
+    uint64_t swaps = panel_legal_swaps(panel);
+
+    while(swaps != 0 && !should_stop(solver)) {
+        int swap = __builtin_ctzll(swaps);
+        swaps &= swaps - 1;
+
+        Panel child = *panel;
+        do_swap(solver, &child, swap);
+
+        path[ply] = swap;
+        solutions += search(solver, task, &child, remaining - 1, path, ply + 1);
+    }
+
+    // a search cut short may have missed solutions
+    if(solutions == 0 && !should_stop(solver)) ttable_store(&solver->ttable, key, 0, remaining);
+
+    return solutions;
+}
+
+static void root_task(void *arg, int worker) {
+    (void)worker;
+    PuzzleRootTask *task = arg;
+    PuzzleSolver *solver = task->solver;
+    if(should_stop(solver)) return;
+
+    Panel panel = solver->root;
+    int path[PUZZLE_MAX_SWAPS];
+    path[0] = task->swap;
+
+    do_swap(solver, &panel, task->swap);
+    search(solver, task, &panel, solver->depth - 1, path, 1);
+}
+
+void puzzle_solve(PuzzleSolver *solver, Puzzle *puzzle, PuzzleSolution *solution) {
+    double start = now_seconds();
+
+    *solution = (PuzzleSolution){ .length = -1 };
+    atomic_store(&solver->nodes, 0);
+    atomic_store(&solver->simulatedTicks, 0);
+    ttable_new_search(&solver->ttable);
+
+    // the blocks of the file may be floating or already making combos
+    puzzle_to_panel(puzzle, &solver->root);
+    atomic_fetch_add(&solver->simulatedTicks, panel_settle(&solver->root));
+
+    uint64_t rootSwaps = panel_legal_swaps(&solver->root);
+
+    for(int depth = 1; depth <= puzzle->swaps && solution->length < 0; depth++) {
+        solver->depth = depth;
+        atomic_store(&solver->solutions, 0);
+
+        // the root swaps are split between the workers
+        int numTasks = 0;
+        for(uint64_t swaps = rootSwaps; swaps != 0; swaps &= swaps - 1) {
+            solver->tasks[numTasks] = (PuzzleRootTask){ .solver = solver, .swap = __builtin_ctzll(swaps) };
+
+            if(solver->pool != NULL) {
+                threadpool_submit(solver->pool, root_task, &solver->tasks[numTasks]);
+            } else {
+                root_task(&solver->tasks[numTasks], 0);
+            }
+            numTasks++;
+        }
+        if(solver->pool != NULL) threadpool_wait(solver->pool);
+
+        int solutions = atomic_load(&solver->solutions);
+        if(solutions == 0) continue;
+
+        solution->length = depth;
+        solution->solutions = MIN(solutions, solver->config.maxSolutions);
+
+        // the lowest root swap that found a solution, so the same solution is
+        // reported no matter how the tasks were scheduled (unless the search stopped early)
+        for(int i = 0; i < numTasks; i++) {
+            if(solver->tasks[i].solutions == 0) continue;
+            memcpy(solution->swaps, solver->tasks[i].solutionSwaps, sizeof(int) * depth);
+            break;
+        }
+    }
+
+    solution->nodes = atomic_load(&solver->nodes);
+    solution->simulatedTicks = atomic_load(&solver->simulatedTicks);
+    solution->time = now_seconds() - start;
+}
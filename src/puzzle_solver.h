@@ -0,0 +1,66 @@
+#ifndef PUZZLE_SOLVER_H
+#define PUZZLE_SOLVER_H
+
+#include "puzzle.h"
+#include "threadpool.h"
+#include "ttable.h"
+
+typedef struct {
+    int threads;         // workers of the pool, 0 uses every core and 1 searches on the calling thread
+    // the search stops once it finds this many solutions of the shortest length,
+    // 1 is enough to validate a puzzle and 2 tells if the solution is unique
+    int maxSolutions;
+    size_t ttableBytes;  // boards known to have no solution, 0 disables it
+} PuzzleSolverConfig;
+
+#define PUZZLE_SOLVER_DEFAULT_CONFIG ((PuzzleSolverConfig){ \
+    .threads = 0,                                          \
+    .maxSolutions = 1,                                     \
+    .ttableBytes = 16 << 20,                               \
+})
+
+typedef struct {
+    // swaps of the shortest solution, -1 if there is none with the puzzle's swaps or less
+    int length;
+    int swaps[PUZZLE_MAX_SWAPS]; // a solution, row * PANEL_SWAPS_PER_ROW + col
+    // solutions (different orders of swaps) of the shortest length, up to maxSolutions
+    int solutions;
+
+    uint64_t nodes;          // boards searched
+    uint64_t simulatedTicks; // panel_update calls
+    double time;
+} PuzzleSolution;
+
+// the search of a root swap, every root swap is a task of the pool
+typedef struct {
+    struct PuzzleSolver *solver;
+    int swap;
+    int solutionSwaps[PUZZLE_MAX_SWAPS]; // the first solution it found, if any
+    int solutions;
+} PuzzleRootTask;
+
+typedef struct PuzzleSolver {
+    PuzzleSolverConfig config;
+    ThreadPool *pool; // NULL with a single thread
+    // boards with no solution in the swaps stored with them, shared by every worker.
+    // It's a fact of the board, so it's kept between puzzles
+    TTable ttable;
+
+    // the state of the running search, read by the tasks
+    Panel root;
+    int depth;
+    PuzzleRootTask tasks[PANEL_NUM_OF_SWAPS];
+    atomic_int solutions;
+    atomic_uint_fast64_t nodes;
+    atomic_uint_fast64_t simulatedTicks;
+} PuzzleSolver;
+
+void puzzle_solver_init(PuzzleSolver *solver, PuzzleSolverConfig config);
+void puzzle_solver_free(PuzzleSolver *solver);
+
+// iterative deepening search over the swap sequences (IDA*) that clear the board,
+// each swap is done on a settled board: after the blocks land and the combos pop.
+// Boards where a color has 1 or 2 blocks left can't be cleared so they're pruned
+void puzzle_solve(PuzzleSolver *solver, Puzzle *puzzle, PuzzleSolution *solution);
+
+#endif // PUZZLE_SOLVER_H
@@ -0,0 +1,234 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "raster.h"
+#include "CCFuncs.h"
+
+// the pixels whose center is inside a rectangle, x1 and y1 are excluded
+typedef struct {
+    int x0, y0, x1, y1;
+} PixelSpan;
+
+Raster *raster_create(int width, int height, const SpriteSheet *sheet, int threads) {
+    assert(width > 0 && height > 0 && "The frame needs a size");
+
+    Raster *raster = calloc(1, sizeof(Raster));
+    assert(raster != NULL && "Not enough memory");
+
+    raster->width = width;
+    raster->height = height;
+    raster->sheet = sheet;
+    raster->tilesX = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    raster->tilesY = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+
+    int numTiles = raster->tilesX * raster->tilesY;
+    raster->pixels = malloc(sizeof(Color) * width * height);
+    raster->bins = calloc(numTiles, sizeof(RasterBin));
+    raster->tasks = malloc(sizeof(RasterTask) * numTiles);
+    assert(raster->pixels != NULL && raster->bins != NULL && raster->tasks != NULL && "Not enough memory");
+
+    for(int i = 0; i < numTiles; i++) {
+        raster->tasks[i] = (RasterTask){ .raster = raster, .tile = i };
+    }
+
+    if(threads != 1 && numTiles > 1) raster->pool = threadpool_create(threads);
+
+    return raster;
+}
+
+void raster_destroy(Raster *raster) {
+    if(raster->pool != NULL) threadpool_destroy(raster->pool);
+    if(raster->sprites.data != NULL) UnloadImage(raster->sprites);
+
+    for(int i = 0; i < raster->tilesX * raster->tilesY; i++) {
+        da_free(&raster->bins[i]);
+    }
+    free(raster->bins);
+    free(raster->tasks);
+    free(raster->pixels);
+    free(raster);
+}
+
+Image raster_image(Raster *raster) {
+    return (Image){
+        .data = raster->pixels,
+        .width = raster->width,
+        .height = raster->height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+}
+
+static PixelSpan covered_pixels(Rectangle rec, PixelSpan clip) {
+    PixelSpan span = {
+        .x0 = MAX((int)ceilf(rec.x - 0.5f), clip.x0),
+        .y0 = MAX((int)ceilf(rec.y - 0.5f), clip.y0),
+        .x1 = MIN((int)ceilf(rec.x + rec.width - 0.5f), clip.x1),
+        .y1 = MIN((int)ceilf(rec.y + rec.height - 0.5f), clip.y1),
+    };
+    return span;
+}
+
+// the same as the default blending of raylib: src * alpha + dst * (1 - alpha)
+static inline Color blend(Color dst, Color src) {
+    if(src.a == 255) return src;
+
+    int a = src.a;
+    int inv = 255 - a;
+    return (Color){
+        (src.r * a + dst.r * inv + 127) / 255,
+        (src.g * a + dst.g * inv + 127) / 255,
+        (src.b * a + dst.b * inv + 127) / 255,
+        a + (dst.a * inv + 127) / 255,
+    };
+}
+
+static inline Color tint(Color c, Color t) {
+    return (Color){
+        (c.r * t.r + 127) / 255,
+        (c.g * t.g + 127) / 255,
+        (c.b * t.b + 127) / 255,
+        (c.a * t.a + 127) / 255,
+    };
+}
+
+static void fill_rect(Raster *raster, Rectangle rec, Color color, PixelSpan clip) {
+    PixelSpan span = covered_pixels(rec, clip);
+
+    for(int y = span.y0; y < span.y1; y++) {
+        Color *row = &raster->pixels[y * raster->width];
+        for(int x = span.x0; x < span.x1; x++) row[x] = blend(row[x], color);
+    }
+}
+
+static void draw_sprite(Raster *raster, const RenderCommand *command, PixelSpan clip) {
+    Rectangle dest = command->dest;
+    PixelSpan span = covered_pixels(dest, clip);
+    bool tinted = command->color.r != 255 || command->color.g != 255 || command->color.b != 255
+        || command->color.a != 255;
+
+    int spriteWidth = raster->spriteWidth;
+    int spriteHeight = raster->spriteHeight;
+    const Color *texels = raster->sprites.data;
+    int firstTexel = spriteWidth * (command->sprite - 1);
+
+    for(int y = span.y0; y < span.y1; y++) {
+        int v = (y + 0.5f - dest.y) * spriteHeight / dest.height;
+        v = MIN(MAX(v, 0), spriteHeight - 1);
+        const Color *spriteRow = &texels[v * raster->sprites.width + firstTexel];
+        Color *row = &raster->pixels[y * raster->width];
+
+        for(int x = span.x0; x < span.x1; x++) {
+            int u = (x + 0.5f - dest.x) * spriteWidth / dest.width;
+            u = MIN(MAX(u, 0), spriteWidth - 1);
+
+            Color texel = spriteRow[u];
+            if(tinted) texel = tint(texel, command->color);
+            row[x] = blend(row[x], texel);
+        }
+    }
+}
+
+static void draw_tile(void *arg, int worker) {
+    (void)worker;
+    RasterTask *task = arg;
+    Raster *raster = task->raster;
+    const RenderList *list = raster->list;
+
+    int tileX = task->tile % raster->tilesX * RASTER_TILE_SIZE;
+    int tileY = task->tile / raster->tilesX * RASTER_TILE_SIZE;
+    PixelSpan clip = {
+        .x0 = tileX,
+        .y0 = tileY,
+        .x1 = MIN(tileX + RASTER_TILE_SIZE, raster->width),
+        .y1 = MIN(tileY + RASTER_TILE_SIZE, raster->height),
+    };
+
+    for(int y = clip.y0; y < clip.y1; y++) {
+        Color *row = &raster->pixels[y * raster->width];
+        for(int x = clip.x0; x < clip.x1; x++) row[x] = raster->background;
+    }
+
+    RasterBin *bin = &raster->bins[task->tile];
+    for(size_t i = 0; i < bin->count; i++) {
+        const RenderCommand *command = &list->items[bin->items[i]];
+
+        switch(command->type) {
+        case RENDER_COMMAND_SPRITE:
+            draw_sprite(raster, command, clip);
+            break;
+        case RENDER_COMMAND_RECT:
+            fill_rect(raster, command->dest, command->color, clip);
+            break;
+        case RENDER_COMMAND_RECT_LINES: {
+            Rectangle sides[4];
+            render_rect_lines_sides(command->dest, command->thickness, sides);
+            for(int j = 0; j < 4; j++) fill_rect(raster, sides[j], command->color, clip);
+            break;
+        }
+        case RENDER_COMMAND_TEXT:
+            break;
+        }
+    }
+}
+
+// the sprites are scaled to the size of the first one, the blocks are all the same size
+static void scale_sprites(Raster *raster, const RenderList *list) {
+    for(size_t i = 0; i < list->count; i++) {
+        const RenderCommand *command = &list->items[i];
+        if(command->type != RENDER_COMMAND_SPRITE) continue;
+
+        int width = command->dest.width;
+        int height = command->dest.height;
+        if(width < 1 || height < 1) continue;
+        if(width == raster->spriteWidth && height == raster->spriteHeight) return;
+
+        if(raster->sprites.data != NULL) UnloadImage(raster->sprites);
+        raster->sprites = sprite_sheet_scale(raster->sheet, width, height);
+        raster->spriteWidth = width;
+        raster->spriteHeight = height;
+        return;
+    }
+}
+
+// every command goes to the bins of the tiles it touches, in order
+static void bin_commands(Raster *raster, const RenderList *list) {
+    int numTiles = raster->tilesX * raster->tilesY;
+    for(int i = 0; i < numTiles; i++) raster->bins[i].count = 0;
+
+    PixelSpan frame = { 0, 0, raster->width, raster->height };
+    for(size_t i = 0; i < list->count; i++) {
+        const RenderCommand *command = &list->items[i];
+        if(command->type == RENDER_COMMAND_TEXT) continue;
+        // there's nothing to sample before the first sprite gets a size
+        if(command->type == RENDER_COMMAND_SPRITE && raster->sprites.data == NULL) continue;
+
+        PixelSpan span = covered_pixels(command->dest, frame);
+        if(span.x0 >= span.x1 || span.y0 >= span.y1) continue;
+
+        for(int ty = span.y0 / RASTER_TILE_SIZE; ty <= (span.y1 - 1) / RASTER_TILE_SIZE; ty++) {
+            for(int tx = span.x0 / RASTER_TILE_SIZE; tx <= (span.x1 - 1) / RASTER_TILE_SIZE; tx++) {
+                da_append(&raster->bins[ty * raster->tilesX + tx], (uint32_t)i);
+            }
+        }
+    }
+}
+
+void raster_draw(Raster *raster, const RenderList *list, Color background) {
+    scale_sprites(raster, list);
+    bin_commands(raster, list);
+
+    raster->list = list;
+    raster->background = background;
+
+    int numTiles = raster->tilesX * raster->tilesY;
+    if(raster->pool == NULL) {
+        for(int i = 0; i < numTiles; i++) draw_tile(&raster->tasks[i], 0);
+        return;
+    }
+
+    for(int i = 0; i < numTiles; i++) {
+        threadpool_submit(raster->pool, draw_tile, &raster->tasks[i]);
+    }
+    threadpool_wait(raster->pool);
+}
@@ -0,0 +1,59 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdint.h>
+
+#include "render_list.h"
+#include "threadpool.h"
+
+// the CPU backend of the render lists, it draws frames without a GPU (or a window).
+// The frame is split in tiles that are drawn in parallel, every tile by a single
+// task with the commands that touch it in the order they were recorded, so the
+// pixels are the same with any number of threads.
+// A pixel is drawn when its center is inside the rectangle. The sprites come from
+// the sheet scaled to the size of the first sprite of the list (the size of the
+// blocks), sprites of other sizes take the nearest texel. Without a window raylib
+// has no font, so the text commands aren't drawn
+#define RASTER_TILE_SIZE 64
+
+typedef struct {
+    uint32_t *items; // indices of the commands
+    size_t count;
+    size_t capacity;
+} RasterBin;
+
+typedef struct Raster Raster;
+
+typedef struct {
+    Raster *raster;
+    int tile;
+} RasterTask;
+
+struct Raster {
+    int width, height;
+    Color *pixels; // row by row from the top, the layout of PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+
+    const SpriteSheet *sheet;
+    Image sprites; // the sheet scaled to spriteWidth x spriteHeight
+    int spriteWidth, spriteHeight;
+
+    int tilesX, tilesY;
+    RasterBin *bins;    // the commands that touch every tile
+    RasterTask *tasks;  // one per tile
+    ThreadPool *pool;   // NULL when the tiles are drawn on the calling thread
+
+    // the frame being drawn, read by the tasks
+    const RenderList *list;
+    Color background;
+};
+
+// threads = 0 uses every core
+Raster *raster_create(int width, int height, const SpriteSheet *sheet, int threads);
+void raster_destroy(Raster *raster);
+
+// clears the frame with the background and draws the list on it
+void raster_draw(Raster *raster, const RenderList *list, Color background);
+// the pixels as a raylib image, it's still owned by the raster
+Image raster_image(Raster *raster);
+
+#endif // RASTER_H
@@ -0,0 +1,184 @@
+// rasterize: draws a game with the CPU rasterizer, without a GPU or a window
+//
+// the panel is simulated for some ticks and the frame is written to a PNG, or
+// compared with one to check that the drawing didn't change (golden images).
+// With --bench it draws a frame every tick and measures recording the render
+// lists apart from rasterizing them. The inputs come from a replay or are random
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raster.h"
+#include "replay.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+#define BLOCKS_SPRITESHEET_FILE "./assets/blocks.png"
+#define BLOCKS_ATLAS_FILE "./assets/blocks.atlas"
+#define RASTERIZE_DEFAULT_TICKS 600
+
+typedef struct {
+    Panel panel;
+    Replay *replay; // NULL for random inputs
+    uint64_t rng;
+    size_t tick;
+} Game;
+
+static void game_tick(Game *game) {
+    uint8_t input = 0;
+    if(game->replay != NULL) {
+        // once the replay ends the panel just keeps going without input
+        if(game->tick < game->replay->count) input = game->replay->items[game->tick];
+    } else {
+        input = 1 << (splitmix64_next(&game->rng) % 8) & 0x1f;
+    }
+
+    panel_apply_input(&game->panel, input);
+    panel_update(&game->panel);
+    game->tick++;
+}
+
+// the pixels that are different, -1 if the image can't be compared
+static long compare_image(Image frame, const char *path) {
+    Image golden = LoadImage(path);
+    if(!IsImageValid(golden)) {
+        log_error("Couldn't load \"%s\"", path);
+        return -1;
+    }
+    ImageFormat(&golden, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    long different = -1;
+    if(golden.width != frame.width || golden.height != frame.height) {
+        log_error("\"%s\" is %dx%d, the frame is %dx%d", path, golden.width, golden.height, frame.width, frame.height);
+    } else {
+        Color *a = frame.data;
+        Color *b = golden.data;
+        different = 0;
+        for(int i = 0; i < frame.width * frame.height; i++) {
+            different += a[i].r != b[i].r || a[i].g != b[i].g || a[i].b != b[i].b || a[i].a != b[i].a;
+        }
+    }
+
+    UnloadImage(golden);
+    return different;
+}
+
+static void run_bench(Game *game, Raster *raster, RenderList *list, int frames) {
+    double recordTime = 0;
+    double rasterTime = 0;
+    size_t commands = 0;
+
+    for(int i = 0; i < frames; i++) {
+        game_tick(game);
+
+        double start = now_seconds();
+        render_list_clear(list);
+        render_list_panel(list, &game->panel, true);
+        double recorded = now_seconds();
+        raster_draw(raster, list, BLACK);
+        double end = now_seconds();
+
+        recordTime += recorded - start;
+        rasterTime += end - recorded;
+        commands += list->count;
+    }
+
+    printf("%d frames of %dx%d (%d tiles)\n", frames, raster->width, raster->height, raster->tilesX * raster->tilesY);
+    printf("  commands per frame: %.1f\n", (double)commands / frames);
+    printf("  recording:          %.3f us per frame\n", recordTime / frames * 1e6);
+    printf("  rasterizing:        %.3f ms per frame (%.0f frames/s)\n", rasterTime / frames * 1e3, frames / rasterTime);
+}
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options] <image.png>\n", program);
+    printf("  --seed <n>       seed used to generate the panel\n");
+    printf("  --replay <file>  plays the inputs of a replay instead of random ones\n");
+    printf("  --ticks <n>      ticks simulated before the frame (default %d)\n", RASTERIZE_DEFAULT_TICKS);
+    printf("  --size <w>x<h>   size of the frame (default 1280x720)\n");
+    printf("  --threads <n>    workers drawing the tiles (default every core)\n");
+    printf("  --compare        compares the frame with the image instead of writing it\n");
+    printf("  --bench <n>      draws a frame on each of the next n ticks and times them, the image is optional\n");
+}
+
+int main(int argc, char **argv) {
+    uint64_t seed = 1;
+    const char *replayPath = NULL;
+    int ticks = RASTERIZE_DEFAULT_TICKS;
+    int width = 1280;
+    int height = 720;
+    int threads = 0;
+    bool compare = false;
+    int benchFrames = 0;
+    const char *imagePath = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--replay") == 0 && hasValue) {
+            replayPath = argv[++i];
+        } else if(strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            ticks = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--size") == 0 && hasValue) {
+            if(sscanf(argv[++i], "%dx%d", &width, &height) != 2) width = 0;
+        } else if(strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--compare") == 0) {
+            compare = true;
+        } else if(strcmp(argv[i], "--bench") == 0 && hasValue) {
+            benchFrames = atoi(argv[++i]);
+        } else if(argv[i][0] != '-' && imagePath == NULL) {
+            imagePath = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(width <= 0 || height <= 0 || ticks < 0 || (imagePath == NULL && benchFrames <= 0)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    Game game = { .rng = seed };
+    Replay replay = {0};
+    if(replayPath != NULL) {
+        if(!replay_load(&replay, replayPath)) return 1;
+        seed = replay.seed;
+        game.replay = &replay;
+    }
+
+    zobrist_init();
+    panel_init(&game.panel, seed);
+    layout_panel(&game.panel, height);
+    for(int i = 0; i < ticks; i++) game_tick(&game);
+
+    SpriteSheet sheet;
+    if(!sprite_sheet_load(&sheet, BLOCKS_SPRITESHEET_FILE, BLOCKS_ATLAS_FILE)) return 1;
+    Raster *raster = raster_create(width, height, &sheet, threads);
+    RenderList list = {0};
+
+    render_list_panel(&list, &game.panel, true);
+    raster_draw(raster, &list, BLACK);
+
+    int result = 0;
+    if(imagePath != NULL && compare) {
+        long different = compare_image(raster_image(raster), imagePath);
+        if(different != 0) result = 1;
+        if(different > 0) printf("%ld pixels are different from \"%s\"\n", different, imagePath);
+    } else if(imagePath != NULL && !ExportImage(raster_image(raster), imagePath)) {
+        log_error("Couldn't write \"%s\"", imagePath);
+        result = 1;
+    }
+
+    if(benchFrames > 0) run_bench(&game, raster, &list, benchFrames);
+
+    render_list_free(&list);
+    raster_destroy(raster);
+    sprite_sheet_unload(&sheet);
+    replay_free(&replay);
+    return result;
+}
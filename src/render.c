@@ -0,0 +1,280 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "render.h"
+#include "rlgl.h"
+#define RAYMATH_STATIC_INLINE
+#include "raymath.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+bool block_atlas_load(BlockAtlas *atlas, const char *texturePath, const char *atlasPath) {
+    *atlas = (BlockAtlas){0};
+    if(!sprite_sheet_load(&atlas->sheet, texturePath, atlasPath)) return false;
+
+    Rectangle first = atlas->sheet.sprites[1];
+    block_atlas_scale(atlas, first.width, first.height);
+    return true;
+}
+
+void block_atlas_unload(BlockAtlas *atlas) {
+    UnloadTexture(atlas->texture);
+    sprite_sheet_unload(&atlas->sheet);
+}
+
+void block_atlas_scale(BlockAtlas *atlas, int blockWidth, int blockHeight) {
+    if(blockWidth == atlas->blockWidth && blockHeight == atlas->blockHeight) return;
+
+    Image image = sprite_sheet_scale(&atlas->sheet, blockWidth, blockHeight);
+    if(IsTextureValid(atlas->texture)) UnloadTexture(atlas->texture);
+    // the sprites are drawn at the size they have, so there's nothing to filter
+    atlas->texture = LoadTextureFromImage(image);
+    SetTextureFilter(atlas->texture, TEXTURE_FILTER_POINT);
+    UnloadImage(image);
+
+    float width = atlas->texture.width;
+    float height = atlas->texture.height;
+    for(int type = 1; type < PANEL_NUM_OF_BLOCK_TYPES; type++) {
+        atlas->uvs[type] = (Rectangle){
+            blockWidth * (type - 1) / width, 0, blockWidth / width, blockHeight / height,
+        };
+    }
+    atlas->white = (Vector2){ 0.5f, (blockHeight + SPRITE_SHEET_WHITE_HEIGHT / 2.0f) / height };
+
+    atlas->blockWidth = blockWidth;
+    atlas->blockHeight = blockHeight;
+    atlas->generation++;
+}
+
+bool renderer_init(Renderer *renderer, const char *texturePath, const char *atlasPath) {
+    *renderer = (Renderer){0};
+    if(!block_atlas_load(&renderer->atlas, texturePath, atlasPath)) return false;
+
+    renderer->vertices = malloc(sizeof(RenderVertex) * 4 * RENDER_MAX_QUADS);
+    assert(renderer->vertices != NULL && "Not enough memory");
+
+    // the indices never change: two triangles per quad
+    uint16_t *indices = malloc(sizeof(uint16_t) * 6 * RENDER_MAX_QUADS);
+    assert(indices != NULL && "Not enough memory");
+    for(int i = 0; i < RENDER_MAX_QUADS; i++) {
+        uint16_t *quad = &indices[i * 6];
+        uint16_t first = i * 4;
+        quad[0] = first;
+        quad[1] = first + 1;
+        quad[2] = first + 2;
+        quad[3] = first;
+        quad[4] = first + 2;
+        quad[5] = first + 3;
+    }
+
+    // the buffers are tied to the vao, so drawing only needs to enable it
+    int *locs = rlGetShaderLocsDefault();
+    renderer->vao = rlLoadVertexArray();
+    rlEnableVertexArray(renderer->vao);
+
+    renderer->vbo = rlLoadVertexBuffer(NULL, sizeof(RenderVertex) * 4 * RENDER_MAX_QUADS, true);
+    rlSetVertexAttribute(locs[RL_SHADER_LOC_VERTEX_POSITION], 2, RL_FLOAT, false,
+        sizeof(RenderVertex), offsetof(RenderVertex, x));
+    rlEnableVertexAttribute(locs[RL_SHADER_LOC_VERTEX_POSITION]);
+    rlSetVertexAttribute(locs[RL_SHADER_LOC_VERTEX_TEXCOORD01], 2, RL_FLOAT, false,
+        sizeof(RenderVertex), offsetof(RenderVertex, u));
+    rlEnableVertexAttribute(locs[RL_SHADER_LOC_VERTEX_TEXCOORD01]);
+    rlSetVertexAttribute(locs[RL_SHADER_LOC_VERTEX_COLOR], 4, RL_UNSIGNED_BYTE, true,
+        sizeof(RenderVertex), offsetof(RenderVertex, color));
+    rlEnableVertexAttribute(locs[RL_SHADER_LOC_VERTEX_COLOR]);
+
+    renderer->ebo = rlLoadVertexBufferElement(indices, sizeof(uint16_t) * 6 * RENDER_MAX_QUADS, false);
+    rlDisableVertexArray();
+    free(indices);
+
+    return true;
+}
+
+void renderer_free(Renderer *renderer) {
+    rlUnloadVertexArray(renderer->vao);
+    rlUnloadVertexBuffer(renderer->vbo);
+    rlUnloadVertexBuffer(renderer->ebo);
+    free(renderer->vertices);
+    render_list_free(&renderer->list);
+    block_atlas_unload(&renderer->atlas);
+}
+
+void renderer_flush(Renderer *renderer) {
+    if(renderer->quadCount == 0) return;
+
+    // whatever raylib batched until now goes below the quads
+    rlDrawRenderBatchActive();
+
+    rlUpdateVertexBuffer(renderer->vbo, renderer->vertices, sizeof(RenderVertex) * 4 * renderer->quadCount, 0);
+
+    int *locs = rlGetShaderLocsDefault();
+    Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    float diffuse[4] = {1, 1, 1, 1};
+    int sampler = 0;
+
+    rlEnableShader(rlGetShaderIdDefault());
+    rlSetUniformMatrix(locs[RL_SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(locs[RL_SHADER_LOC_COLOR_DIFFUSE], diffuse, RL_SHADER_UNIFORM_VEC4, 1);
+    rlSetUniform(locs[RL_SHADER_LOC_MAP_DIFFUSE], &sampler, RL_SHADER_UNIFORM_INT, 1);
+    rlActiveTextureSlot(0);
+    rlEnableTexture(renderer->atlas.texture.id);
+
+    rlEnableVertexArray(renderer->vao);
+    rlDrawVertexArrayElements(0, 6 * renderer->quadCount, 0);
+    rlDisableVertexArray();
+
+    rlDisableTexture();
+    rlDisableShader();
+
+    renderer->stats.drawCalls++;
+    renderer->quadCount = 0;
+}
+
+void renderer_begin_frame(Renderer *renderer) {
+    renderer->stats.drawCalls = 0;
+    renderer->stats.quads = 0;
+    renderer->stats.redrawnCells = 0;
+    renderer->frameStart = now_seconds();
+}
+
+void renderer_end_frame(Renderer *renderer) {
+    renderer_flush(renderer);
+
+    RenderStats *stats = &renderer->stats;
+    stats->cpuTime = now_seconds() - renderer->frameStart;
+
+    stats->frames++;
+    stats->totalDrawCalls += stats->drawCalls;
+    stats->totalCpuTime += stats->cpuTime;
+}
+
+void render_quad(Renderer *renderer, Rectangle dest, Rectangle uv, Color color) {
+    if(renderer->quadCount == RENDER_MAX_QUADS) renderer_flush(renderer);
+
+    // counter clockwise from the top left corner
+    RenderVertex *v = &renderer->vertices[renderer->quadCount * 4];
+    v[0] = (RenderVertex){ dest.x, dest.y, uv.x, uv.y, color };
+    v[1] = (RenderVertex){ dest.x, dest.y + dest.height, uv.x, uv.y + uv.height, color };
+    v[2] = (RenderVertex){ dest.x + dest.width, dest.y + dest.height, uv.x + uv.width, uv.y + uv.height, color };
+    v[3] = (RenderVertex){ dest.x + dest.width, dest.y, uv.x + uv.width, uv.y, color };
+
+    renderer->quadCount++;
+    renderer->stats.quads++;
+}
+
+static void render_rect(Renderer *renderer, Rectangle dest, Color color) {
+    Vector2 white = renderer->atlas.white;
+    render_quad(renderer, dest, (Rectangle){ white.x, white.y, 0, 0 }, color);
+}
+
+void renderer_draw_list(Renderer *renderer, const RenderList *list) {
+    for(size_t i = 0; i < list->count; i++) {
+        const RenderCommand *command = &list->items[i];
+
+        switch(command->type) {
+        case RENDER_COMMAND_SPRITE:
+            render_quad(renderer, command->dest, renderer->atlas.uvs[command->sprite], command->color);
+            break;
+        case RENDER_COMMAND_RECT:
+            render_rect(renderer, command->dest, command->color);
+            break;
+        case RENDER_COMMAND_RECT_LINES: {
+            Rectangle sides[4];
+            render_rect_lines_sides(command->dest, command->thickness, sides);
+            for(int j = 0; j < 4; j++) render_rect(renderer, sides[j], command->color);
+            break;
+        }
+        case RENDER_COMMAND_TEXT:
+            renderer_flush(renderer);
+            DrawText(render_command_text(list, command), command->dest.x, command->dest.y,
+                command->fontSize, command->color);
+            break;
+        }
+    }
+}
+
+void panel_cache_init(PanelCache *cache, int width, int height) {
+    cache->target = LoadRenderTexture(width, height);
+    cache->atlasGeneration = 0;
+    memset(cache->cells, PANEL_CACHE_UNKNOWN, sizeof(cache->cells));
+}
+
+void panel_cache_free(PanelCache *cache) {
+    UnloadRenderTexture(cache->target);
+}
+
+// draws the cells that changed on the cache texture
+static void update_cache(Renderer *renderer, PanelCache *cache, Panel *panel) {
+    int blockWidth = panel->size.x / PANEL_NUM_OF_COLS;
+    int blockHeight = panel->size.y / PANEL_NUM_OF_ROWS;
+    RenderList *list = &renderer->list;
+    render_list_clear(list);
+
+    // the blocks already drawn have the sprites of the old texture
+    if(cache->atlasGeneration != renderer->atlas.generation) {
+        memset(cache->cells, PANEL_CACHE_UNKNOWN, sizeof(cache->cells));
+        cache->atlasGeneration = renderer->atlas.generation;
+    }
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlockType type = panel_resting_block(get_block(panel, row, col));
+            if(cache->cells[row][col] == type) continue;
+
+            // the background is drawn too so the cell doesn't keep the previous block
+            Rectangle dest = { blockWidth * col, blockHeight * row, blockWidth, blockHeight };
+            render_list_rect(list, dest, PANEL_BACKGROUND);
+            render_list_block(list, type, dest, BLANK);
+
+            cache->cells[row][col] = type;
+            renderer->stats.redrawnCells++;
+        }
+    }
+
+    if(list->count == 0) return;
+
+    // the quads already added go to the screen, not to the texture
+    renderer_flush(renderer);
+    BeginTextureMode(cache->target);
+    renderer_draw_list(renderer, list);
+    renderer_flush(renderer);
+    EndTextureMode();
+}
+
+void render_panel(Renderer *renderer, PanelCache *cache, Panel *panel) {
+    int blockWidth = panel->size.x / PANEL_NUM_OF_COLS;
+    int blockHeight = panel->size.y / PANEL_NUM_OF_ROWS;
+
+    // the quads of other panels still use the old texture
+    if(blockWidth != renderer->atlas.blockWidth || blockHeight != renderer->atlas.blockHeight) {
+        renderer_flush(renderer);
+        block_atlas_scale(&renderer->atlas, blockWidth, blockHeight);
+    }
+
+    if(cache != NULL) {
+        if(cache->target.texture.width != panel->size.x || cache->target.texture.height != panel->size.y) {
+            panel_cache_free(cache);
+            panel_cache_init(cache, panel->size.x, panel->size.y);
+        }
+        update_cache(renderer, cache, panel);
+
+        // render textures are upside down
+        Texture2D texture = cache->target.texture;
+        Rectangle source = { 0, 0, texture.width, -texture.height };
+        DrawTextureRec(texture, source, (Vector2){ panel->pos.x, panel->pos.y }, WHITE);
+    }
+
+    render_list_clear(&renderer->list);
+    render_list_panel(&renderer->list, panel, cache == NULL);
+    renderer_draw_list(renderer, &renderer->list);
+}
+
+void render_stats(Renderer *renderer, int x, int y) {
+    RenderStats *stats = &renderer->stats;
+    render_list_clear(&renderer->list);
+    render_list_text(&renderer->list, TextFormat("%d draw calls, %d quads, %d cells redrawn, %.3f ms",
+        stats->drawCalls, stats->quads, stats->redrawnCells, stats->cpuTime * 1000), x, y, 20, GREEN);
+    renderer_draw_list(renderer, &renderer->list);
+}
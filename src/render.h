@@ -0,0 +1,108 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdbool.h>
+
+#include "raylib.h"
+#include "panel.h"
+#include "render_list.h"
+
+// the sprite sheet on the GPU: the texture has every sprite resampled to the size
+// of the blocks on screen, so drawing them is a 1:1 copy, and the white strip below
+// them for the solid quads
+typedef struct {
+    SpriteSheet sheet;
+
+    Texture2D texture;
+    int blockWidth, blockHeight;             // size of the sprites of the texture
+    unsigned int generation;                 // changes every time the texture is made again
+    Rectangle uvs[PANEL_NUM_OF_BLOCK_TYPES]; // texture coordinates of the sprites
+    Vector2 white;                           // texture coordinates of a white texel
+} BlockAtlas;
+
+// the texture starts with the sprites at the size they have in the image
+bool block_atlas_load(BlockAtlas *atlas, const char *texturePath, const char *atlasPath);
+void block_atlas_unload(BlockAtlas *atlas);
+// makes the texture again if the blocks are drawn at another size
+void block_atlas_scale(BlockAtlas *atlas, int blockWidth, int blockHeight);
+
+// what drawing a frame took, the draw calls are the batches submitted to the GPU
+// by the renderer (raylib's own draws, like the text, aren't counted)
+typedef struct {
+    int drawCalls;
+    int quads;
+    int redrawnCells; // cells of the cached panels drawn again
+    double cpuTime; // seconds building the frame, without waiting for the GPU or vsync
+
+    // since the renderer was created, to print averages
+    uint64_t frames;
+    uint64_t totalDrawCalls;
+    double totalCpuTime;
+} RenderStats;
+
+typedef struct {
+    float x, y;
+    float u, v;
+    Color color;
+} RenderVertex;
+
+// quads that fit in a batch, the indices are 16 bits
+#define RENDER_MAX_QUADS 4096
+
+// the raylib backend of the render lists: every quad of the frame (blocks, overlays
+// and cursors of every panel) goes to a single vertex buffer that is drawn with one
+// draw call when the frame ends
+typedef struct {
+    BlockAtlas atlas;
+    RenderStats stats;
+    double frameStart;
+    RenderList list; // recorded and drawn by the render_ functions below
+
+    RenderVertex *vertices;
+    int quadCount;
+    unsigned int vao;
+    unsigned int vbo;
+    unsigned int ebo;
+} Renderer;
+
+// needs the window to be open
+bool renderer_init(Renderer *renderer, const char *texturePath, const char *atlasPath);
+void renderer_free(Renderer *renderer);
+
+// the frame's stats are measured between these two. The quads are drawn when the
+// frame ends, on top of everything raylib drew before that
+void renderer_begin_frame(Renderer *renderer);
+void renderer_end_frame(Renderer *renderer);
+// draws the quads added so far, there's no need to call it unless something
+// drawn by raylib has to go on top of them
+void renderer_flush(Renderer *renderer);
+
+void render_quad(Renderer *renderer, Rectangle dest, Rectangle uv, Color color);
+// adds the quads of the commands, the text is drawn by raylib so the quads before
+// it are drawn first
+void renderer_draw_list(Renderer *renderer, const RenderList *list);
+
+// the blocks that don't move stay drawn on a texture, every frame only the cells
+// that changed are drawn again on it before it's copied to the screen. The falling
+// and popping blocks and the cursor are drawn on top of it every frame
+#define PANEL_CACHE_UNKNOWN 0xff
+
+typedef struct {
+    RenderTexture2D target;
+    unsigned int atlasGeneration; // the cells are drawn again when the atlas changes
+    // the resting block drawn on every cell of the texture, PANEL_CACHE_UNKNOWN
+    // when the cell has to be drawn no matter what
+    uint8_t cells[PANEL_NUM_OF_ROWS][PANEL_NUM_OF_COLS];
+} PanelCache;
+
+void panel_cache_init(PanelCache *cache, int width, int height);
+void panel_cache_free(PanelCache *cache);
+
+// the blocks, the cursor and the combos that are popping. Without a cache every
+// block is drawn, the cache is created again if the panel changes its size (and
+// the atlas is scaled to the new size of the blocks)
+void render_panel(Renderer *renderer, PanelCache *cache, Panel *panel);
+// the stats of the last frame on a corner of the screen
+void render_stats(Renderer *renderer, int x, int y);
+
+#endif // RENDER_H
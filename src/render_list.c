@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "render_list.h"
+
+// the names of the blocks in the atlas files, in the order of PanelBlockType
+static const char *blockNames[PANEL_NUM_OF_BLOCK_TYPES] = {
+    [PANEL_BLOCK_YELLOW] = "yellow",
+    [PANEL_BLOCK_RED] = "red",
+    [PANEL_BLOCK_PURPLE] = "purple",
+    [PANEL_BLOCK_GREEN] = "green",
+    [PANEL_BLOCK_BLUE] = "blue",
+    [PANEL_BLOCK_DARK_BLUE] = "dark_blue",
+};
+
+// the combo blocks that didn't pop yet are drawn with this on top
+#define COMBO_OVERLAY ((Color){255, 255, 255, 120})
+#define CURSOR_THICKNESS 3
+
+static bool read_atlas(SpriteSheet *sheet, const char *path) {
+    FILE *f = fopen(path, "r");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+
+    while(fgets(line, sizeof(line), f) != NULL) {
+        lineNumber++;
+        if(line[0] == '#') continue;
+
+        char name[32];
+        Rectangle rec;
+        int fields = sscanf(line, "%31s %f %f %f %f", name, &rec.x, &rec.y, &rec.width, &rec.height);
+        if(fields == EOF) continue;
+        if(fields != 5) {
+            log_error("%s:%d: expected \"<block> <x> <y> <width> <height>\"", path, lineNumber);
+            ok = false;
+            break;
+        }
+
+        int type = 1;
+        while(type < PANEL_NUM_OF_BLOCK_TYPES && strcmp(name, blockNames[type]) != 0) type++;
+        if(type == PANEL_NUM_OF_BLOCK_TYPES) {
+            log_error("%s:%d: unknown block \"%s\"", path, lineNumber, name);
+            ok = false;
+            break;
+        }
+
+        sheet->sprites[type] = rec;
+    }
+
+    fclose(f);
+    if(!ok) return false;
+
+    for(int type = 1; type < PANEL_NUM_OF_BLOCK_TYPES; type++) {
+        if(sheet->sprites[type].width <= 0) {
+            log_error("\"%s\" has no sprite for %s blocks", path, blockNames[type]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool sprite_sheet_load(SpriteSheet *sheet, const char *imagePath, const char *atlasPath) {
+    *sheet = (SpriteSheet){0};
+    if(!read_atlas(sheet, atlasPath)) return false;
+
+    sheet->image = LoadImage(imagePath);
+    if(!IsImageValid(sheet->image)) {
+        log_error("Couldn't load \"%s\"", imagePath);
+        return false;
+    }
+    ImageFormat(&sheet->image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    for(int type = 1; type < PANEL_NUM_OF_BLOCK_TYPES; type++) {
+        Rectangle sprite = sheet->sprites[type];
+        if(sprite.x < 0 || sprite.y < 0 || sprite.x + sprite.width > sheet->image.width
+            || sprite.y + sprite.height > sheet->image.height) {
+            log_error("The %s sprite of \"%s\" is outside of \"%s\"", blockNames[type], atlasPath, imagePath);
+            UnloadImage(sheet->image);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void sprite_sheet_unload(SpriteSheet *sheet) {
+    UnloadImage(sheet->image);
+}
+
+Image sprite_sheet_scale(const SpriteSheet *sheet, int width, int height) {
+    assert(width > 0 && height > 0 && "The sprites need a size");
+
+    int numSprites = PANEL_NUM_OF_BLOCK_TYPES - 1;
+    Image image = GenImageColor(width * numSprites, height + SPRITE_SHEET_WHITE_HEIGHT, WHITE);
+    uint8_t *pixels = image.data;
+
+    for(int type = 1; type < PANEL_NUM_OF_BLOCK_TYPES; type++) {
+        // resized on its own so the filter doesn't mix it with the sprites around it
+        Image sprite = ImageFromImage(sheet->image, sheet->sprites[type]);
+        ImageResize(&sprite, width, height);
+
+        int x = width * (type - 1);
+        for(int row = 0; row < height; row++) {
+            memcpy(pixels + (row * image.width + x) * 4, (uint8_t *)sprite.data + row * width * 4, width * 4);
+        }
+        UnloadImage(sprite);
+    }
+
+    return image;
+}
+
+void render_list_clear(RenderList *list) {
+    list->count = 0;
+    list->text.count = 0;
+}
+
+void render_list_free(RenderList *list) {
+    da_free(list);
+    da_free(&list->text);
+}
+
+void render_list_sprite(RenderList *list, PanelBlockType type, Rectangle dest, Color tint) {
+    RenderCommand command = { .type = RENDER_COMMAND_SPRITE, .dest = dest, .color = tint, .sprite = type };
+    da_append(list, command);
+}
+
+void render_list_rect(RenderList *list, Rectangle dest, Color color) {
+    RenderCommand command = { .type = RENDER_COMMAND_RECT, .dest = dest, .color = color };
+    da_append(list, command);
+}
+
+void render_list_rect_lines(RenderList *list, Rectangle rec, float thickness, Color color) {
+    RenderCommand command = { .type = RENDER_COMMAND_RECT_LINES, .dest = rec, .color = color, .thickness = thickness };
+    da_append(list, command);
+}
+
+void render_list_text(RenderList *list, const char *text, int x, int y, int fontSize, Color color) {
+    RenderCommand command = {
+        .type = RENDER_COMMAND_TEXT,
+        .dest = { x, y, 0, 0 },
+        .color = color,
+        .fontSize = fontSize,
+        .text = list->text.count,
+    };
+    da_append_many(&list->text, text, strlen(text) + 1);
+    da_append(list, command);
+}
+
+const char *render_command_text(const RenderList *list, const RenderCommand *command) {
+    return &list->text.items[command->text];
+}
+
+void render_rect_lines_sides(Rectangle rec, float thickness, Rectangle sides[4]) {
+    sides[0] = (Rectangle){ rec.x, rec.y, rec.width, thickness };
+    sides[1] = (Rectangle){ rec.x, rec.y + rec.height - thickness, rec.width, thickness };
+    sides[2] = (Rectangle){ rec.x, rec.y + thickness, thickness, rec.height - thickness * 2 };
+    sides[3] = (Rectangle){ rec.x + rec.width - thickness, rec.y + thickness, thickness, rec.height - thickness * 2 };
+}
+
+void layout_panel(Panel *panel, int screenHeight) {
+    int blockSize = MAX(screenHeight / PANEL_NUM_OF_ROWS, 1);
+    panel->size.x = blockSize * PANEL_NUM_OF_COLS;
+    panel->size.y = blockSize * PANEL_NUM_OF_ROWS;
+}
+
+PanelBlockType panel_resting_block(PanelBlock *block) {
+    bool resting = !block->inCombo && block->currentY == block->row * PANEL_BLOCK_FALLING_TICKS;
+    return resting ? block->type : PANEL_BLOCK_NONE;
+}
+
+void render_list_block(RenderList *list, PanelBlockType type, Rectangle dest, Color overlay) {
+    if(type == PANEL_BLOCK_NONE) return;
+
+    render_list_sprite(list, type, dest, WHITE);
+    if(overlay.a > 0) render_list_rect(list, dest, overlay);
+}
+
+void render_list_panel(RenderList *list, Panel *panel, bool restingBlocks) {
+    int blockWidth = panel->size.x / PANEL_NUM_OF_COLS;
+    int blockHeight = panel->size.y / PANEL_NUM_OF_ROWS;
+
+    // the blocks in a combo are drawn with the combos, the popped ones aren't drawn anymore
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            if(block->type == PANEL_BLOCK_NONE || block->inCombo) continue;
+            if(!restingBlocks && panel_resting_block(block) != PANEL_BLOCK_NONE) continue;
+
+            Rectangle dest = {
+                .x = panel->pos.x + blockWidth * col,
+                .y = panel->pos.y + blockHeight * block->currentY / PANEL_BLOCK_FALLING_TICKS,
+                .width = blockWidth,
+                .height = blockHeight,
+            };
+            render_list_block(list, block->type, dest, BLANK);
+        }
+    }
+
+    // the animation is kinds ugly, but it works for now
+    for(size_t i = 0; i < panel->combos.count; i++) {
+        Combo *combo = &panel->combos.items[i];
+
+        for(size_t j = 0; j < combo->count; j++) {
+            if(combo->time > ((int)j + 1) * PANEL_POP_BLOCK_TICKS + PANEL_POP_IDLE_TICKS) continue;
+
+            PanelBlock *block = get_combo_block(panel, combo, j);
+            Rectangle dest = {
+                .x = panel->pos.x + blockWidth * block->col,
+                .y = panel->pos.y + blockHeight * block->row,
+                .width = blockWidth,
+                .height = blockHeight,
+            };
+            render_list_block(list, block->type, dest, COMBO_OVERLAY);
+        }
+    }
+
+    Rectangle cursorRec = {
+        .x = panel->pos.x + panel->cursor.x * blockWidth,
+        .y = panel->pos.y + panel->cursor.y * blockHeight,
+        .width = blockWidth * 2,
+        .height = blockHeight,
+    };
+    render_list_rect_lines(list, cursorRec, CURSOR_THICKNESS, WHITE);
+
+#ifdef DEBUG
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            if(block->type == PANEL_BLOCK_NONE) continue;
+
+            int posX = panel->pos.x + blockWidth * col;
+            int posY = panel->pos.y + blockHeight * block->currentY / PANEL_BLOCK_FALLING_TICKS;
+            char text[32];
+            snprintf(text, sizeof(text), "(%d, %d)", block->col, block->row);
+            render_list_text(list, text, posX + blockWidth / 2, posY + blockHeight / 2, 10, WHITE);
+        }
+    }
+#endif
+}
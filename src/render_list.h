@@ -0,0 +1,92 @@
+#ifndef RENDER_LIST_H
+#define RENDER_LIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "raylib.h"
+#include "panel.h"
+#include "CCFuncs.h"
+
+// what gets drawn is recorded in a render list that is drawn later by a backend:
+// the Renderer (render.h) with raylib or the Raster (raster.h) on the CPU. Only the
+// raylib types are used here, nothing needs a window
+
+// the sprite of every block type in an image, read once from the atlas file next
+// to it: a "<block> <x> <y> <width> <height>" line per sprite. Only the CPU side of
+// raylib is used so it can be loaded without a window
+typedef struct {
+    Image image;
+    Rectangle sprites[PANEL_NUM_OF_BLOCK_TYPES]; // in pixels, PANEL_BLOCK_NONE has no sprite
+} SpriteSheet;
+
+bool sprite_sheet_load(SpriteSheet *sheet, const char *imagePath, const char *atlasPath);
+void sprite_sheet_unload(SpriteSheet *sheet);
+
+// rows of white pixels below the scaled sprites, so the solid quads can be drawn
+// with the same texture. The white texel is in the middle of them so it's never
+// mixed with the sprites
+#define SPRITE_SHEET_WHITE_HEIGHT 2
+
+// every sprite resampled to width x height, side by side in the order of the types
+// (the yellow one at x = 0) with the white strip below them
+Image sprite_sheet_scale(const SpriteSheet *sheet, int width, int height);
+
+typedef enum {
+    RENDER_COMMAND_SPRITE,
+    RENDER_COMMAND_RECT,
+    RENDER_COMMAND_RECT_LINES,
+    RENDER_COMMAND_TEXT,
+} RenderCommandType;
+
+typedef struct {
+    RenderCommandType type;
+    Rectangle dest;        // for text only x and y are used
+    Color color;           // the sprites are multiplied by it
+    PanelBlockType sprite; // RENDER_COMMAND_SPRITE
+    float thickness;       // RENDER_COMMAND_RECT_LINES
+    int fontSize;          // RENDER_COMMAND_TEXT
+    size_t text;           // RENDER_COMMAND_TEXT, offset of the string in the list's text
+} RenderCommand;
+
+// the commands are drawn in order, each one on top of the ones before it
+typedef struct {
+    RenderCommand *items;
+    size_t count;
+    size_t capacity;
+
+    StringBuilder text; // the strings of the text commands, null terminated
+} RenderList;
+
+// keeps the memory for the next frame
+void render_list_clear(RenderList *list);
+void render_list_free(RenderList *list);
+
+void render_list_sprite(RenderList *list, PanelBlockType type, Rectangle dest, Color tint);
+void render_list_rect(RenderList *list, Rectangle dest, Color color);
+void render_list_rect_lines(RenderList *list, Rectangle rec, float thickness, Color color);
+void render_list_text(RenderList *list, const char *text, int x, int y, int fontSize, Color color);
+
+const char *render_command_text(const RenderList *list, const RenderCommand *command);
+// the rectangles a backend fills for a RENDER_COMMAND_RECT_LINES: the top and
+// bottom lines are as wide as the rectangle, the sides go between them
+void render_rect_lines_sides(Rectangle rec, float thickness, Rectangle sides[4]);
+
+// the color of the panel where there are no blocks
+#define PANEL_BACKGROUND BLACK
+
+// the panel takes the height of the screen, the blocks have a whole number of
+// pixels so their sprites are drawn 1:1
+void layout_panel(Panel *panel, int screenHeight);
+
+// the block of the cell if it's resting there, blocks that are falling or in a
+// combo change every frame
+PanelBlockType panel_resting_block(PanelBlock *block);
+// the sprite of the type with an overlay of the given color on top of it (a
+// transparent one for none), the only way a block is drawn
+void render_list_block(RenderList *list, PanelBlockType type, Rectangle dest, Color overlay);
+// the blocks that are falling or popping and the cursor, plus the resting blocks
+// unless the backend keeps them drawn somewhere else
+void render_list_panel(RenderList *list, Panel *panel, bool restingBlocks);
+
+#endif // RENDER_LIST_H
@@ -0,0 +1,120 @@
+#include <inttypes.h>
+#include <string.h>
+
+#include "replay.h"
+#include "CCFuncs.h"
+
+// the numbers are always stored in little endian so the file is the same on every machine
+static void write_u32(FILE *f, uint32_t value) {
+    for(int i = 0; i < 4; i++) fputc((value >> (i * 8)) & 0xff, f);
+}
+
+static void write_u64(FILE *f, uint64_t value) {
+    for(int i = 0; i < 8; i++) fputc((value >> (i * 8)) & 0xff, f);
+}
+
+static bool read_u32(FILE *f, uint32_t *value) {
+    uint8_t bytes[4];
+    if(fread(bytes, 1, 4, f) != 4) return false;
+
+    *value = 0;
+    for(int i = 0; i < 4; i++) *value |= (uint32_t)bytes[i] << (i * 8);
+    return true;
+}
+
+static bool read_u64(FILE *f, uint64_t *value) {
+    uint8_t bytes[8];
+    if(fread(bytes, 1, 8, f) != 8) return false;
+
+    *value = 0;
+    for(int i = 0; i < 8; i++) *value |= (uint64_t)bytes[i] << (i * 8);
+    return true;
+}
+
+bool replay_save(Replay *replay, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    fwrite(REPLAY_MAGIC, 1, 4, f);
+    write_u32(f, REPLAY_VERSION);
+    write_u64(f, replay->seed);
+    write_u32(f, replay->count);
+    fwrite(replay->items, 1, replay->count, f);
+
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+bool replay_load(Replay *replay, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version, count;
+    *replay = (Replay){0};
+
+    if(fread(magic, 1, 4, f) != 4 || memcmp(magic, REPLAY_MAGIC, 4) != 0
+        || !read_u32(f, &version) || version != REPLAY_VERSION
+        || !read_u64(f, &replay->seed) || !read_u32(f, &count)) {
+        log_error("\"%s\" is not a valid replay", path);
+        fclose(f);
+        return false;
+    }
+
+    // the count comes from the file, it can't be bigger than what's left of it
+    long start = ftell(f);
+    fseek(f, 0, SEEK_END);
+    long end = ftell(f);
+    if(start < 0 || end < 0 || count > (uint64_t)(end - start)) {
+        log_error("\"%s\" is truncated", path);
+        fclose(f);
+        return false;
+    }
+    fseek(f, start, SEEK_SET);
+
+    replay->items = malloc(count);
+    assert((replay->items != NULL || count == 0) && "Not enough memory");
+    replay->count = replay->capacity = count;
+
+    if(fread(replay->items, 1, count, f) != count) {
+        log_error("\"%s\" is truncated", path);
+        replay_free(replay);
+        fclose(f);
+        return false;
+    }
+
+    fclose(f);
+    return true;
+}
+
+void replay_free(Replay *replay) {
+    da_free(replay);
+    *replay = (Replay){0};
+}
+
+void hashlog_write(FILE *f, size_t tick, PanelStateHash *hash) {
+    fprintf(f, "%zu %016" PRIx64 " %016" PRIx64, tick, hash->full, hash->misc);
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        fprintf(f, " %016" PRIx64, hash->rows[row]);
+    }
+
+    fputc('\n', f);
+}
+
+bool hashlog_read(FILE *f, size_t *tick, PanelStateHash *hash) {
+    if(fscanf(f, "%zu %" SCNx64 " %" SCNx64, tick, &hash->full, &hash->misc) != 3) return false;
+
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        if(fscanf(f, "%" SCNx64, &hash->rows[row]) != 1) return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "panel.h"
+
+#define REPLAY_MAGIC "TARP"
+#define REPLAY_VERSION 1
+
+// a replay is the seed of the panel plus the input of every tick, since the
+// simulation is deterministic that's enough to play the whole game again
+typedef struct {
+    uint64_t seed;
+
+    uint8_t *items; // PanelInput flags, one per tick
+    size_t count;
+    size_t capacity;
+} Replay;
+
+bool replay_save(Replay *replay, const char *path);
+bool replay_load(Replay *replay, const char *path);
+void replay_free(Replay *replay);
+
+// the hash log is a text file with the state hash of every tick:
+// "<tick> <full> <misc> <row 0> ... <row 11>" (all in hex), the text format
+// allows to compare logs made by different builds with plain diff
+void hashlog_write(FILE *f, size_t tick, PanelStateHash *hash);
+// returns false when there are no more ticks
+bool hashlog_read(FILE *f, size_t *tick, PanelStateHash *hash);
+
+#endif // REPLAY_H
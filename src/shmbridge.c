@@ -0,0 +1,155 @@
+// shmbridge: runs headless panels driven by an agent through shared memory
+//
+// the simulation side creates the bridge file and steps the panels every time
+// the agent submits actions, see bridge.h for the format and the protocol.
+// With --agent it's the other side instead: a random agent that measures how
+// many steps per second go through the bridge
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bridge.h"
+#include "env.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+_Static_assert(BRIDGE_OBSERVATION_SIZE == ENV_OBSERVATION_SIZE, "The bridge observations are the env ones");
+
+#define SHMBRIDGE_DEFAULT_ENVS 256
+#define SHMBRIDGE_DEFAULT_SLOTS 4
+#define SHMBRIDGE_DEFAULT_MAX_STEPS 3600
+
+int run_simulation(const char *path, uint32_t numEnvs, uint32_t slots, uint64_t seed, int maxSteps, int threads) {
+    BridgeHeader *header = bridge_create(path, numEnvs, slots);
+    if(header == NULL) return 1;
+
+    Env *env = env_create(numEnvs, seed, maxSteps, threads);
+
+    // observation set 0 is the start of the first episodes
+    env_reset(env, bridge_observations(header, 0));
+    memset(bridge_rewards(header, 0), 0, sizeof(float) * numEnvs);
+    memset(bridge_dones(header, 0), 0, numEnvs);
+    bridge_publish(&header->stepsDone, 1);
+
+    printf("bridge ready at %s: %u panels, %u slots\n", path, numEnvs, slots);
+
+    uint32_t processed = 0;
+    double busyTime = 0;
+    double start = now_seconds();
+
+    while(true) {
+        // the agent writes its last actions before closing, so once it's closed
+        // reading the counter gets everything it submitted
+        bool closed = atomic_load(&header->closed);
+        uint32_t requested = closed
+            ? atomic_load(&header->stepsRequested)
+            : bridge_wait(header, &header->stepsRequested, processed);
+        double stepStart = now_seconds();
+
+        // the agent may have submitted more than one action set
+        for(; processed != requested; processed++) {
+            env_step_batch(env, bridge_actions(header, processed), bridge_observations(header, processed + 1),
+                bridge_rewards(header, processed + 1), bridge_dones(header, processed + 1));
+            bridge_publish(&header->stepsDone, processed + 2);
+        }
+
+        busyTime += now_seconds() - stepStart;
+
+        if(closed) break;
+    }
+
+    double elapsed = now_seconds() - start;
+    printf("agent closed the bridge after %u steps (%.0f panel steps/s, simulating %.0f%% of the time)\n",
+        processed, (double)processed * numEnvs / elapsed, 100 * busyTime / elapsed);
+
+    env_destroy(env);
+    bridge_close(header);
+    return 0;
+}
+
+int run_agent(const char *path, uint32_t steps, uint64_t seed) {
+    BridgeHeader *header = bridge_open(path);
+    if(header == NULL) return 1;
+
+    uint32_t numEnvs = header->numEnvs;
+    uint64_t rng = seed;
+    double reward = 0;
+    double start = now_seconds();
+
+    for(uint32_t step = 0; step < steps; step++) {
+        // observation set "step" is the one the actions are decided from
+        bridge_wait(header, &header->stepsDone, step);
+
+        float *rewards = bridge_rewards(header, step);
+        for(uint32_t i = 0; i < numEnvs; i++) reward += rewards[i];
+
+        uint8_t *actions = bridge_actions(header, step);
+        for(uint32_t i = 0; i < numEnvs; i++) {
+            actions[i] = 1 << (splitmix64_next(&rng) % 8) & 0x1f;
+        }
+        bridge_publish(&header->stepsRequested, step + 1);
+    }
+
+    double elapsed = now_seconds() - start;
+    printf("%u steps of %u panels in %.3fs\n", steps, numEnvs, elapsed);
+    printf("  steps/s:        %.0f (%.1fus per round trip)\n", steps / elapsed, elapsed / steps * 1e6);
+    printf("  panel steps/s:  %.0f\n", (double)steps * numEnvs / elapsed);
+    printf("  blocks cleared: %.0f\n", reward);
+
+    atomic_store(&header->closed, 1);
+    bridge_publish(&header->stepsRequested, steps);
+
+    bridge_close(header);
+    return 0;
+}
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options] <bridge file>\n", program);
+    printf("  --envs <n>       panels (default %d)\n", SHMBRIDGE_DEFAULT_ENVS);
+    printf("  --slots <n>      entries of the rings (default %d)\n", SHMBRIDGE_DEFAULT_SLOTS);
+    printf("  --seed <n>       seed of the panels (or of the random agent)\n");
+    printf("  --max-steps <n>  length of an episode (default %d)\n", SHMBRIDGE_DEFAULT_MAX_STEPS);
+    printf("  --threads <n>    workers stepping the panels (default every core)\n");
+    printf("  --agent <steps>  opens an existing bridge and plays randomly instead\n");
+}
+
+int main(int argc, char **argv) {
+    uint32_t numEnvs = SHMBRIDGE_DEFAULT_ENVS;
+    uint32_t slots = SHMBRIDGE_DEFAULT_SLOTS;
+    uint64_t seed = 1;
+    int maxSteps = SHMBRIDGE_DEFAULT_MAX_STEPS;
+    int threads = 0;
+    uint32_t agentSteps = 0;
+    const char *path = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--envs") == 0 && hasValue) {
+            numEnvs = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--slots") == 0 && hasValue) {
+            slots = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--max-steps") == 0 && hasValue) {
+            maxSteps = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--agent") == 0 && hasValue) {
+            agentSteps = strtoul(argv[++i], NULL, 10);
+        } else if(argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(path == NULL || numEnvs == 0 || slots == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if(agentSteps > 0) return run_agent(path, agentSteps, seed);
+    return run_simulation(path, numEnvs, slots, seed, maxSteps, threads);
+}
@@ -0,0 +1,95 @@
+// solve: validates puzzle files
+//
+// every puzzle has to be cleared with exactly its swaps, a puzzle that can be
+// cleared with less swaps or that can't be cleared at all is reported
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "puzzle_solver.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options] <puzzle file>...\n", program);
+    printf("  --threads <n>  workers of the solver (default every core)\n");
+    printf("  --unique       also checks every puzzle has a single solution\n");
+    printf("  --quiet        only prints the puzzles that aren't valid\n");
+}
+
+int main(int argc, char **argv) {
+    PuzzleSolverConfig config = PUZZLE_SOLVER_DEFAULT_CONFIG;
+    bool unique = false;
+    bool quiet = false;
+    Puzzles puzzles = {0};
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--threads") == 0 && hasValue) {
+            config.threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--unique") == 0) {
+            unique = true;
+        } else if(strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if(argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else if(!puzzle_load_file(&puzzles, argv[i])) {
+            return 1;
+        }
+    }
+
+    if(puzzles.count == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    zobrist_init();
+
+    if(unique) config.maxSolutions = 2;
+    PuzzleSolver solver;
+    puzzle_solver_init(&solver, config);
+
+    double start = now_seconds();
+    size_t valid = 0;
+
+    for(size_t i = 0; i < puzzles.count; i++) {
+        Puzzle *puzzle = &puzzles.items[i];
+        PuzzleSolution solution;
+        puzzle_solve(&solver, puzzle, &solution);
+
+        bool ok = solution.length == puzzle->swaps && (!unique || solution.solutions == 1);
+        if(ok) valid++;
+        if(ok && quiet) continue;
+
+        printf("%s: ", puzzle->name);
+        if(solution.length < 0) {
+            printf("no solution with %d swaps", puzzle->swaps);
+        } else if(solution.length < puzzle->swaps) {
+            printf("can be solved with %d swaps instead of %d", solution.length, puzzle->swaps);
+        } else if(unique && solution.solutions > 1) {
+            printf("more than one solution");
+        } else {
+            printf("ok");
+        }
+
+        if(solution.length > 0) {
+            printf(" (");
+            for(int j = 0; j < solution.length; j++) {
+                int swap = solution.swaps[j];
+                printf("%s%d,%d", j > 0 ? " " : "", swap / PANEL_SWAPS_PER_ROW, swap % PANEL_SWAPS_PER_ROW);
+            }
+            printf(")");
+        }
+        printf(", %llu boards in %.3fs\n", (unsigned long long)solution.nodes, solution.time);
+    }
+
+    printf("%zu of %zu puzzles valid in %.3fs (%d workers)\n",
+        valid, puzzles.count, now_seconds() - start, solver.pool != NULL ? solver.pool->numWorkers : 1);
+
+    puzzle_solver_free(&solver);
+    da_free(&puzzles);
+
+    return valid == puzzles.count ? 0 : 1;
+}
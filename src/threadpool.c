@@ -0,0 +1,173 @@
+#include <unistd.h>
+
+#include "threadpool.h"
+#include "CCFuncs.h"
+
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} WorkerArgs;
+
+// the worker index of the current thread, -1 outside the pool
+static _Thread_local int currentWorker = -1;
+static _Thread_local ThreadPool *currentPool = NULL;
+
+int get_num_of_cores(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? cores : 1;
+}
+
+static bool queue_pop_back(WorkerQueue *queue, Task *task) {
+    pthread_mutex_lock(&queue->lock);
+    bool found = queue->count > queue->head;
+    if(found) {
+        *task = queue->items[--queue->count];
+        if(queue->count == queue->head) queue->count = queue->head = 0;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+static bool queue_steal_front(WorkerQueue *queue, Task *task) {
+    pthread_mutex_lock(&queue->lock);
+    bool found = queue->count > queue->head;
+    if(found) {
+        *task = queue->items[queue->head++];
+        if(queue->count == queue->head) queue->count = queue->head = 0;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+static bool get_task(ThreadPool *pool, int worker, Task *task) {
+    if(queue_pop_back(&pool->queues[worker], task)) return true;
+
+    // start with the next worker so the thieves don't all go to the same queue
+    for(int i = 1; i < pool->numWorkers; i++) {
+        int victim = (worker + i) % pool->numWorkers;
+        if(queue_steal_front(&pool->queues[victim], task)) return true;
+    }
+
+    return false;
+}
+
+static void *worker_loop(void *data) {
+    WorkerArgs *args = data;
+    ThreadPool *pool = args->pool;
+    int worker = args->index;
+    free(args);
+
+    currentWorker = worker;
+    currentPool = pool;
+
+    while(true) {
+        Task task;
+
+        if(get_task(pool, worker, &task)) {
+            atomic_fetch_sub(&pool->queued, 1);
+            task.func(task.arg, worker);
+
+            if(atomic_fetch_sub(&pool->pending, 1) == 1) {
+                pthread_mutex_lock(&pool->lock);
+                pthread_cond_broadcast(&pool->allDone);
+                pthread_mutex_unlock(&pool->lock);
+            }
+            continue;
+        }
+
+        // "queued" is updated before signaling with the lock taken, so checking
+        // it with the lock taken can't miss a task
+        pthread_mutex_lock(&pool->lock);
+        while(atomic_load(&pool->queued) == 0 && !pool->stop) {
+            pthread_cond_wait(&pool->workAvailable, &pool->lock);
+        }
+        bool stop = pool->stop;
+        pthread_mutex_unlock(&pool->lock);
+
+        if(stop) break;
+    }
+
+    return NULL;
+}
+
+ThreadPool *threadpool_create(int numWorkers) {
+    if(numWorkers <= 0) numWorkers = get_num_of_cores();
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    assert(pool != NULL && "Not enough memory");
+
+    pool->numWorkers = numWorkers;
+    pool->threads = calloc(numWorkers, sizeof(pthread_t));
+    pool->queues = calloc(numWorkers, sizeof(WorkerQueue));
+    assert(pool->threads != NULL && pool->queues != NULL && "Not enough memory");
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->workAvailable, NULL);
+    pthread_cond_init(&pool->allDone, NULL);
+
+    for(int i = 0; i < numWorkers; i++) {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+
+    for(int i = 0; i < numWorkers; i++) {
+        WorkerArgs *args = malloc(sizeof(WorkerArgs));
+        assert(args != NULL && "Not enough memory");
+        *args = (WorkerArgs){ .pool = pool, .index = i };
+        pthread_create(&pool->threads[i], NULL, worker_loop, args);
+    }
+
+    return pool;
+}
+
+void threadpool_destroy(ThreadPool *pool) {
+    threadpool_wait(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->workAvailable);
+    pthread_mutex_unlock(&pool->lock);
+
+    // every worker must be stopped before destroying the queues since they steal from each other
+    for(int i = 0; i < pool->numWorkers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    for(int i = 0; i < pool->numWorkers; i++) {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+        da_free(&pool->queues[i]);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->workAvailable);
+    pthread_cond_destroy(&pool->allDone);
+
+    free(pool->threads);
+    free(pool->queues);
+    free(pool);
+}
+
+void threadpool_submit(ThreadPool *pool, TaskFunc func, void *arg) {
+    int queueIndex = currentPool == pool
+        ? currentWorker
+        : (int)(atomic_fetch_add(&pool->nextQueue, 1) % pool->numWorkers);
+    WorkerQueue *queue = &pool->queues[queueIndex];
+
+    atomic_fetch_add(&pool->pending, 1);
+
+    pthread_mutex_lock(&queue->lock);
+    da_append(queue, ((Task){ .func = func, .arg = arg }));
+    pthread_mutex_unlock(&queue->lock);
+
+    pthread_mutex_lock(&pool->lock);
+    atomic_fetch_add(&pool->queued, 1);
+    pthread_cond_signal(&pool->workAvailable);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void threadpool_wait(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while(atomic_load(&pool->pending) > 0) {
+        pthread_cond_wait(&pool->allDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
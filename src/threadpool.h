@@ -0,0 +1,54 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// worker is the index of the worker running the task, useful to give every worker
+// its own copy of the data so the tasks don't need locks
+typedef void (*TaskFunc)(void *arg, int worker);
+
+typedef struct {
+    TaskFunc func;
+    void *arg;
+} Task;
+
+// every worker has its own deque, the owner pushes and pops from the back (so it
+// keeps working on the data that is hot in its cache) and the others steal from the front
+typedef struct {
+    pthread_mutex_t lock;
+    Task *items;
+    size_t count;
+    size_t capacity;
+    size_t head; // index of the first task, the ones before it were stolen
+} WorkerQueue;
+
+typedef struct {
+    pthread_t *threads;
+    WorkerQueue *queues;
+    int numWorkers;
+
+    atomic_size_t queued;  // tasks waiting on a queue
+    atomic_size_t pending; // tasks not finished yet
+    atomic_uint nextQueue; // queue of the next task submitted from outside the pool
+    bool stop;
+
+    pthread_mutex_t lock;
+    pthread_cond_t workAvailable;
+    pthread_cond_t allDone;
+} ThreadPool;
+
+// numWorkers = 0 creates a worker per core
+ThreadPool *threadpool_create(int numWorkers);
+void threadpool_destroy(ThreadPool *pool);
+
+// tasks submitted from a worker go to its own queue, the others are spread between all queues
+void threadpool_submit(ThreadPool *pool, TaskFunc func, void *arg);
+// blocks until every submitted task is finished
+void threadpool_wait(ThreadPool *pool);
+
+int get_num_of_cores(void);
+
+#endif // THREADPOOL_H
@@ -0,0 +1,29 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <errno.h>
+#include <time.h>
+
+// monotonic time in seconds, only useful to measure intervals
+static inline double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// a time of now_seconds() for the functions that take an absolute CLOCK_MONOTONIC time
+static inline struct timespec timespec_from_seconds(double seconds) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - ts.tv_sec) * 1e9);
+    return ts;
+}
+
+// sleeps until now_seconds() reaches the given time, without drifting like a
+// relative sleep would
+static inline void sleep_until_seconds(double seconds) {
+    struct timespec ts = timespec_from_seconds(seconds);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+}
+
+#endif // TIMER_H
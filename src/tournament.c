@@ -0,0 +1,420 @@
+// tournament: round-robin between the bots, headless
+//
+// there's no versus mode (the panels don't send garbage to each other), so a
+// match is a race: both bots play a panel made from the same seed and the one
+// that clears more blocks wins, the one that cleared them first if it's a tie.
+// The two games of a match don't interact so they're played one after the other,
+// which also gives the time every bot takes. The matches run on every core
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bot.h"
+#include "mcts.h"
+#include "puzzle.h"
+#include "threadpool.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+#define TOURNAMENT_DEFAULT_GAMES 4
+#define TOURNAMENT_DEFAULT_TICKS 3600
+// there are no new blocks so a game is over once the bot can't clear anything else
+#define TOURNAMENT_STALL_TICKS 300
+
+// a bot that can take part, the state is created for every game
+typedef struct {
+    const char *name;
+    void *(*create)(uint64_t seed);
+    uint8_t (*input)(void *bot, Panel *panel);
+    void (*destroy)(void *bot);
+} BotEntry;
+
+// the searches always run to the end so the results don't depend on the machine's load
+static void *create_beam_bot(BeamBotConfig config) {
+    BeamBot *bot = malloc(sizeof(BeamBot));
+    assert(bot != NULL && "Not enough memory");
+    config.timeBudget = 0;
+    beam_bot_init(bot, config);
+    return bot;
+}
+
+static void *create_beam(uint64_t seed) {
+    (void)seed;
+    return create_beam_bot(BEAM_BOT_DEFAULT_CONFIG);
+}
+
+static void *create_beam_wide(uint64_t seed) {
+    (void)seed;
+    BeamBotConfig config = BEAM_BOT_DEFAULT_CONFIG;
+    config.beamWidth = 16;
+    config.depth = 3;
+    return create_beam_bot(config);
+}
+
+static void *create_greedy(uint64_t seed) {
+    (void)seed;
+    BeamBotConfig config = BEAM_BOT_DEFAULT_CONFIG;
+    config.beamWidth = 1;
+    config.depth = 1;
+    return create_beam_bot(config);
+}
+
+static uint8_t beam_input(void *bot, Panel *panel) {
+    return beam_bot_input(bot, panel);
+}
+
+static void destroy_beam(void *bot) {
+    beam_bot_free(bot);
+    free(bot);
+}
+
+static void *create_mcts(uint64_t seed) {
+    MctsBot *bot = malloc(sizeof(MctsBot));
+    assert(bot != NULL && "Not enough memory");
+
+    // the matches already use every core
+    MctsBotConfig config = MCTS_BOT_DEFAULT_CONFIG;
+    config.threads = 1;
+    config.timeBudget = 0;
+    config.seed = seed;
+    mcts_bot_init(bot, config);
+    return bot;
+}
+
+static uint8_t mcts_input(void *bot, Panel *panel) {
+    return mcts_bot_input(bot, panel);
+}
+
+static void destroy_mcts(void *bot) {
+    mcts_bot_free(bot);
+    free(bot);
+}
+
+// walks to random legal swaps, the baseline every bot should beat
+typedef struct {
+    uint64_t rng;
+    int target;
+} RandomBot;
+
+static void *create_random(uint64_t seed) {
+    RandomBot *bot = malloc(sizeof(RandomBot));
+    assert(bot != NULL && "Not enough memory");
+    *bot = (RandomBot){ .rng = seed, .target = -1 };
+    return bot;
+}
+
+static uint8_t random_input(void *arg, Panel *panel) {
+    RandomBot *bot = arg;
+
+    if(bot->target < 0) {
+        uint64_t legal = panel_legal_swaps(panel);
+        if(legal == 0) return 0;
+
+        int n = splitmix64_next(&bot->rng) % __builtin_popcountll(legal);
+        while(n-- > 0) legal &= legal - 1;
+        bot->target = __builtin_ctzll(legal);
+    }
+
+    return bot_walk_to_swap(panel, &bot->target);
+}
+
+static const BotEntry BOTS[] = {
+    { "beam",      create_beam,      beam_input,   destroy_beam },
+    { "beam-wide", create_beam_wide, beam_input,   destroy_beam },
+    { "greedy",    create_greedy,    beam_input,   destroy_beam },
+    { "mcts",      create_mcts,      mcts_input,   destroy_mcts },
+    { "random",    create_random,    random_input, free },
+};
+
+#define NUM_OF_BOTS ((int)(sizeof(BOTS) / sizeof(BOTS[0])))
+
+typedef struct {
+    uint32_t cleared;
+    int lastClearTick; // the tick the last block was cleared, -1 if none was
+    int ticks;         // ticks played until the game ended
+    double time;
+} GameResult;
+
+typedef struct {
+    int bots[2]; // indices in BOTS
+    uint64_t seed;
+    int maxTicks;
+    GameResult results[2];
+} Match;
+
+typedef struct {
+    int wins;
+    int draws;
+    int losses;
+    uint64_t cleared;
+    uint64_t ticks;
+    double time;
+} Standing;
+
+static GameResult play_game(const BotEntry *entry, uint64_t seed, int maxTicks) {
+    GameResult result = { .lastClearTick = -1 };
+    double start = now_seconds();
+
+    void *bot = entry->create(seed);
+    Panel panel = {0};
+    panel_init(&panel, seed);
+
+    int lastActiveTick = 0;
+    int tick = 0;
+    for(; tick < maxTicks && tick - lastActiveTick < TOURNAMENT_STALL_TICKS && !panel_is_empty(&panel); tick++) {
+        uint32_t cleared = panel.clearedBlocks;
+
+        panel_apply_input(&panel, entry->input(bot, &panel));
+        panel_update(&panel);
+
+        if(panel.clearedBlocks != cleared) result.lastClearTick = tick;
+        if(panel.clearedBlocks != cleared || panel.combos.count > 0) lastActiveTick = tick;
+    }
+
+    entry->destroy(bot);
+
+    result.cleared = panel.clearedBlocks;
+    result.ticks = tick;
+    result.time = now_seconds() - start;
+    return result;
+}
+
+static void play_match(void *arg, int worker) {
+    (void)worker;
+    Match *match = arg;
+
+    for(int side = 0; side < 2; side++) {
+        match->results[side] = play_game(&BOTS[match->bots[side]], match->seed, match->maxTicks);
+    }
+}
+
+// 1 if the first side won, -1 if the second one did and 0 for a draw
+static int match_winner(Match *match) {
+    GameResult *a = &match->results[0];
+    GameResult *b = &match->results[1];
+
+    if(a->cleared != b->cleared) return a->cleared > b->cleared ? 1 : -1;
+    if(a->lastClearTick != b->lastClearTick) return a->lastClearTick < b->lastClearTick ? 1 : -1;
+    return 0;
+}
+
+static int find_bot(const char *name) {
+    for(int i = 0; i < NUM_OF_BOTS; i++) {
+        if(strcmp(BOTS[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// parses a comma separated list of bots, returns how many there are or -1 if the list isn't valid
+static int parse_bots(char *list, int *bots) {
+    int count = 0;
+    bool used[NUM_OF_BOTS] = {0};
+
+    for(char *name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+        int bot = find_bot(name);
+        if(bot < 0) {
+            log_error("Unknown bot \"%s\"", name);
+            return -1;
+        }
+        if(used[bot]) {
+            log_error("\"%s\" is in the list twice", name);
+            return -1;
+        }
+
+        used[bot] = true;
+        bots[count++] = bot;
+    }
+
+    return count;
+}
+
+static bool write_json(const char *path, int *bots, Standing *standings, int numBots,
+                       int numMatches, double matchTicks, double elapsed, double ticksPerSecond) {
+    FILE *f = fopen(path, "w");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"matches\": %d,\n", numMatches);
+    fprintf(f, "  \"averageMatchTicks\": %.1f,\n", matchTicks);
+    fprintf(f, "  \"seconds\": %.3f,\n", elapsed);
+    fprintf(f, "  \"ticksPerSecond\": %.0f,\n", ticksPerSecond);
+    fprintf(f, "  \"bots\": [\n");
+
+    for(int i = 0; i < numBots; i++) {
+        Standing *s = &standings[i];
+        fprintf(f, "    {\"name\": \"%s\", \"wins\": %d, \"draws\": %d, \"losses\": %d, "
+            "\"blocksPerGame\": %.1f, \"ticksPerGame\": %.1f, \"ticksPerSecond\": %.0f}%s\n",
+            BOTS[bots[i]].name, s->wins, s->draws, s->losses,
+            (double)s->cleared / (s->wins + s->draws + s->losses),
+            (double)s->ticks / (s->wins + s->draws + s->losses),
+            s->ticks / s->time, i + 1 < numBots ? "," : "");
+    }
+
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+
+    bool ok = !ferror(f);
+    if(fclose(f) != 0) ok = false;
+    return ok;
+}
+
+static bool write_csv(const char *path, int *bots, Standing *standings, int numBots) {
+    FILE *f = fopen(path, "w");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    fprintf(f, "bot,wins,draws,losses,blocks_per_game,ticks_per_game,ticks_per_second\n");
+    for(int i = 0; i < numBots; i++) {
+        Standing *s = &standings[i];
+        int games = s->wins + s->draws + s->losses;
+        fprintf(f, "%s,%d,%d,%d,%.1f,%.1f,%.0f\n", BOTS[bots[i]].name, s->wins, s->draws, s->losses,
+            (double)s->cleared / games, (double)s->ticks / games, s->ticks / s->time);
+    }
+
+    bool ok = !ferror(f);
+    if(fclose(f) != 0) ok = false;
+    return ok;
+}
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --bots <a,b,...>  bots that play (default all of them):");
+    for(int i = 0; i < NUM_OF_BOTS; i++) printf(" %s", BOTS[i].name);
+    printf("\n");
+    printf("  --games <n>       matches between every pair of bots (default %d)\n", TOURNAMENT_DEFAULT_GAMES);
+    printf("  --ticks <n>       max ticks of a game (default %d)\n", TOURNAMENT_DEFAULT_TICKS);
+    printf("  --seed <n>        seed of the panels\n");
+    printf("  --threads <n>     matches played at the same time (default every core)\n");
+    printf("  --json <file>     writes the summary as JSON\n");
+    printf("  --csv <file>      writes the summary as CSV\n");
+}
+
+int main(int argc, char **argv) {
+    int bots[NUM_OF_BOTS];
+    int numBots = NUM_OF_BOTS;
+    for(int i = 0; i < NUM_OF_BOTS; i++) bots[i] = i;
+
+    int games = TOURNAMENT_DEFAULT_GAMES;
+    int maxTicks = TOURNAMENT_DEFAULT_TICKS;
+    uint64_t seed = 1;
+    int threads = 0;
+    const char *jsonPath = NULL;
+    const char *csvPath = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--bots") == 0 && hasValue) {
+            numBots = parse_bots(argv[++i], bots);
+            if(numBots < 0) return 1;
+        } else if(strcmp(argv[i], "--games") == 0 && hasValue) {
+            games = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            maxTicks = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        } else if(strcmp(argv[i], "--csv") == 0 && hasValue) {
+            csvPath = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(numBots < 2 || games <= 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    zobrist_init();
+
+    // every pair plays the same seeds, so every bot gets the same boards
+    int numMatches = numBots * (numBots - 1) / 2 * games;
+    Match *matches = malloc(sizeof(Match) * numMatches);
+    assert(matches != NULL && "Not enough memory");
+
+    int count = 0;
+    for(int a = 0; a < numBots; a++) {
+        for(int b = a + 1; b < numBots; b++) {
+            for(int game = 0; game < games; game++) {
+                uint64_t state = seed + game;
+                matches[count++] = (Match){
+                    .bots = { bots[a], bots[b] },
+                    .seed = splitmix64_next(&state),
+                    .maxTicks = maxTicks,
+                };
+            }
+        }
+    }
+
+    ThreadPool *pool = threadpool_create(threads);
+    printf("%d bots, %d matches on %d workers\n", numBots, numMatches, pool->numWorkers);
+
+    double start = now_seconds();
+    for(int i = 0; i < numMatches; i++) {
+        threadpool_submit(pool, play_match, &matches[i]);
+    }
+    threadpool_wait(pool);
+    double elapsed = now_seconds() - start;
+
+    // the standings are in the order of the bots given
+    Standing standings[NUM_OF_BOTS] = {0};
+    int standingOf[NUM_OF_BOTS];
+    for(int i = 0; i < numBots; i++) standingOf[bots[i]] = i;
+
+    uint64_t totalTicks = 0;
+    uint64_t matchTicks = 0;
+    for(int i = 0; i < numMatches; i++) {
+        Match *match = &matches[i];
+        int winner = match_winner(match);
+
+        for(int side = 0; side < 2; side++) {
+            Standing *s = &standings[standingOf[match->bots[side]]];
+            GameResult *result = &match->results[side];
+            int sign = side == 0 ? winner : -winner;
+
+            if(sign > 0) s->wins++;
+            else if(sign < 0) s->losses++;
+            else s->draws++;
+
+            s->cleared += result->cleared;
+            s->ticks += result->ticks;
+            s->time += result->time;
+            totalTicks += result->ticks;
+        }
+
+        matchTicks += MAX(match->results[0].ticks, match->results[1].ticks);
+    }
+
+    double ticksPerSecond = totalTicks / elapsed;
+    double averageMatchTicks = (double)matchTicks / numMatches;
+
+    printf("%-10s %5s %5s %5s %8s %8s %12s\n", "bot", "wins", "draws", "losses", "blocks", "ticks", "ticks/s");
+    for(int i = 0; i < numBots; i++) {
+        Standing *s = &standings[i];
+        int played = s->wins + s->draws + s->losses;
+        printf("%-10s %5d %5d %5d %8.1f %8.1f %12.0f\n", BOTS[bots[i]].name, s->wins, s->draws, s->losses,
+            (double)s->cleared / played, (double)s->ticks / played, s->ticks / s->time);
+    }
+    printf("%d matches in %.3fs, %.1f ticks per match, %.0f game ticks/s\n",
+        numMatches, elapsed, averageMatchTicks, ticksPerSecond);
+
+    bool ok = true;
+    if(jsonPath != NULL) {
+        ok = write_json(jsonPath, bots, standings, numBots, numMatches, averageMatchTicks, elapsed, ticksPerSecond) && ok;
+    }
+    if(csvPath != NULL) ok = write_csv(csvPath, bots, standings, numBots) && ok;
+
+    threadpool_destroy(pool);
+    free(matches);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include <string.h>
+
+#include "trajectory.h"
+#include "env.h"
+#include "CCFuncs.h"
+
+// the header written to new files and expected in the existing ones
+static void make_header(uint8_t header[TRAJECTORY_HEADER_SIZE]) {
+    uint32_t fields[3] = { TRAJECTORY_VERSION, TRAJECTORY_HEADER_SIZE, TRAJECTORY_RECORD_SIZE };
+
+    memset(header, 0, TRAJECTORY_HEADER_SIZE);
+    memcpy(header, TRAJECTORY_MAGIC, 4);
+    memcpy(header + 4, fields, sizeof(fields));
+}
+
+// checks the header of an existing file and that it only has whole records
+static bool check_file(FILE *f, const char *path) {
+    uint8_t expected[TRAJECTORY_HEADER_SIZE];
+    uint8_t header[TRAJECTORY_HEADER_SIZE];
+    make_header(expected);
+
+    if(fread(header, 1, sizeof(header), f) != sizeof(header)
+        || memcmp(header, expected, sizeof(header)) != 0) {
+        log_error("\"%s\" isn't a trajectory file of this version", path);
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    if((size - TRAJECTORY_HEADER_SIZE) % TRAJECTORY_RECORD_SIZE != 0) {
+        log_error("\"%s\" ends with a partial record", path);
+        return false;
+    }
+
+    return true;
+}
+
+static void *writer_thread(void *arg) {
+    TrajectoryWriter *writer = arg;
+
+    pthread_mutex_lock(&writer->lock);
+    while(true) {
+        while(writer->writeCount == 0 && !writer->closing) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        if(writer->writeCount == 0) break;
+
+        // the block the game isn't filling
+        TrajectoryRecord *block = writer->blocks[1 - writer->filling];
+        size_t count = writer->writeCount;
+        pthread_mutex_unlock(&writer->lock);
+
+        bool ok = fwrite(block, sizeof(TrajectoryRecord), count, writer->f) == count
+            && fflush(writer->f) == 0;
+
+        pthread_mutex_lock(&writer->lock);
+        if(!ok) writer->failed = true;
+        writer->writeCount = 0;
+        pthread_cond_broadcast(&writer->cond);
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+bool trajectory_writer_open(TrajectoryWriter *writer, const char *path) {
+    *writer = (TrajectoryWriter){0};
+
+    // "a+" so the records always go to the end, even if something else appends too
+    writer->f = fopen(path, "a+b");
+    if(writer->f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    fseek(writer->f, 0, SEEK_END);
+    if(ftell(writer->f) == 0) {
+        uint8_t header[TRAJECTORY_HEADER_SIZE];
+        make_header(header);
+        fwrite(header, 1, sizeof(header), writer->f);
+    } else {
+        rewind(writer->f);
+        if(!check_file(writer->f, path)) {
+            fclose(writer->f);
+            return false;
+        }
+    }
+
+    for(int i = 0; i < 2; i++) {
+        writer->blocks[i] = malloc(sizeof(TrajectoryRecord) * TRAJECTORY_BLOCK_RECORDS);
+        assert(writer->blocks[i] != NULL && "Not enough memory");
+    }
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+    pthread_create(&writer->thread, NULL, writer_thread, writer);
+    return true;
+}
+
+// hands the block being filled to the thread and starts filling the other one
+static void submit_block(TrajectoryWriter *writer) {
+    pthread_mutex_lock(&writer->lock);
+    // only waits if the thread is still writing the previous block
+    while(writer->writeCount > 0) {
+        pthread_cond_wait(&writer->cond, &writer->lock);
+    }
+
+    writer->writeCount = writer->count;
+    writer->filling = 1 - writer->filling;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+
+    writer->count = 0;
+}
+
+void trajectory_writer_append(TrajectoryWriter *writer, const TrajectoryRecord *record) {
+    writer->blocks[writer->filling][writer->count++] = *record;
+    if(writer->count == TRAJECTORY_BLOCK_RECORDS) submit_block(writer);
+}
+
+bool trajectory_writer_close(TrajectoryWriter *writer) {
+    if(writer->count > 0) submit_block(writer);
+
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = true;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    bool ok = !writer->failed;
+    if(fclose(writer->f) != 0) ok = false;
+
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->cond);
+    free(writer->blocks[0]);
+    free(writer->blocks[1]);
+    return ok;
+}
+
+void trajectory_record_board(TrajectoryRecord *record, Panel *panel) {
+    for(int row = 0; row < PANEL_NUM_OF_ROWS; row++) {
+        for(int col = 0; col < PANEL_NUM_OF_COLS; col++) {
+            PanelBlock *block = get_block(panel, row, col);
+            record->cells[row * PANEL_NUM_OF_COLS + col] = block->type
+                | (block->inCombo ? ENV_CELL_IN_COMBO : 0)
+                | (block->falling ? ENV_CELL_FALLING : 0);
+        }
+    }
+
+    record->cursorX = panel->cursor.x;
+    record->cursorY = panel->cursor.y;
+}
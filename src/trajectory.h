@@ -0,0 +1,80 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "panel.h"
+
+// a trajectory file has the (board, action, reward, chain) of every tick played,
+// for training. It's a TRAJECTORY_HEADER_SIZE bytes header followed by fixed size
+// records, so a consumer can map the file and use it as an array of TrajectoryRecord.
+// The file is only appended to, games played later are added at the end.
+//
+// all the numbers are little endian, the structs are written as they're in memory
+//
+// the header:
+//   [0, 4)   "TATR"
+//   [4, 8)   u32 version
+//   [8, 12)  u32 header size (TRAJECTORY_HEADER_SIZE)
+//   [12, 16) u32 record size (TRAJECTORY_RECORD_SIZE)
+//   the rest is zero
+#define TRAJECTORY_MAGIC "TATR"
+#define TRAJECTORY_VERSION 1
+#define TRAJECTORY_HEADER_SIZE 64
+#define TRAJECTORY_RECORD_SIZE 96
+
+// records buffered before they're written, a block is ~384KB
+#define TRAJECTORY_BLOCK_RECORDS 4096
+
+_Static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "The trajectory records are written as they're in memory");
+
+// the board is the state before the action, the reward and the chain are the
+// result of applying the action and simulating the tick
+typedef struct {
+    uint64_t seed;   // seed of the panel, tells the games of the file apart
+    uint32_t tick;   // tick of the game, 0 is the first one
+    uint16_t reward; // blocks cleared in the tick
+    uint8_t action;  // PanelInput flags
+    uint8_t chain;   // Panel.chain after the tick
+    // a byte per cell, row by row from the top, same encoding as the env
+    // observations: the PanelBlockType in the low 3 bits, 0x08 in a combo, 0x10 falling
+    uint8_t cells[PANEL_NUM_OF_CELLS];
+    uint8_t cursorX;
+    uint8_t cursorY;
+    uint8_t padding[6];
+} TrajectoryRecord;
+
+_Static_assert(sizeof(TrajectoryRecord) == TRAJECTORY_RECORD_SIZE, "The trajectory records must keep their size");
+
+// the game fills a block while a background thread writes the other one, so the
+// game never waits for the disk (unless it fills a whole block before the thread
+// writes the previous one)
+typedef struct {
+    FILE *f;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    TrajectoryRecord *blocks[2];
+    int filling;   // block the game appends to, changed with the lock held
+    size_t count;  // records in the block being filled, only used by the game
+
+    // protected by the lock
+    size_t writeCount; // records of the other block waiting to be written, 0 when there's none
+    bool closing;
+    bool failed;
+} TrajectoryWriter;
+
+// opens (or creates) the file, returns false if it can't be used
+bool trajectory_writer_open(TrajectoryWriter *writer, const char *path);
+void trajectory_writer_append(TrajectoryWriter *writer, const TrajectoryRecord *record);
+// writes the records left and closes the file, returns false if any write failed
+bool trajectory_writer_close(TrajectoryWriter *writer);
+
+// fills the board and the cursor of the record
+void trajectory_record_board(TrajectoryRecord *record, Panel *panel);
+
+#endif // TRAJECTORY_H
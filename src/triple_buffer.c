@@ -0,0 +1,29 @@
+#include "triple_buffer.h"
+
+void triple_buffer_init(TripleBuffer *buffer, void *a, void *b, void *c) {
+    buffer->slots[0] = a;
+    buffer->slots[1] = b;
+    buffer->slots[2] = c;
+    buffer->back = 0;
+    buffer->front = 2;
+    atomic_init(&buffer->middle, 1);
+}
+
+void *triple_buffer_back(TripleBuffer *buffer) {
+    return buffer->slots[buffer->back];
+}
+
+void triple_buffer_publish(TripleBuffer *buffer) {
+    // the release makes the writes to the slot visible to the reader that takes it
+    unsigned int old = atomic_exchange_explicit(&buffer->middle, buffer->back | TRIPLE_BUFFER_FRESH,
+        memory_order_acq_rel);
+    buffer->back = old & ~TRIPLE_BUFFER_FRESH;
+}
+
+void *triple_buffer_read(TripleBuffer *buffer) {
+    if(atomic_load_explicit(&buffer->middle, memory_order_relaxed) & TRIPLE_BUFFER_FRESH) {
+        unsigned int old = atomic_exchange_explicit(&buffer->middle, buffer->front, memory_order_acq_rel);
+        buffer->front = old & ~TRIPLE_BUFFER_FRESH;
+    }
+    return buffer->slots[buffer->front];
+}
@@ -0,0 +1,31 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdatomic.h>
+
+// hands values from a single writer thread to a single reader thread without
+// locks: the writer always has a slot of its own to write the next value, the
+// reader always gets the last value published, and none of them ever waits.
+// Values published while the reader was busy are skipped. The slots belong to
+// the caller, the buffer only passes their ownership around
+typedef struct {
+    void *slots[3];
+    int back;  // written by the writer
+    int front; // read by the reader
+    // the slot between them, with TRIPLE_BUFFER_FRESH when the reader didn't take it yet
+    atomic_uint middle;
+} TripleBuffer;
+
+#define TRIPLE_BUFFER_FRESH 4u
+
+// the reader starts with the third slot, it has to be valid before anything is published
+void triple_buffer_init(TripleBuffer *buffer, void *a, void *b, void *c);
+
+// the slot the writer can fill, it's the writer's until it's published
+void *triple_buffer_back(TripleBuffer *buffer);
+void triple_buffer_publish(TripleBuffer *buffer);
+
+// the last slot published, it's the reader's (and it doesn't change) until the next call
+void *triple_buffer_read(TripleBuffer *buffer);
+
+#endif // TRIPLE_BUFFER_H
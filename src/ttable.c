@@ -0,0 +1,150 @@
+#include <string.h>
+
+#include "ttable.h"
+#include "CCFuncs.h"
+
+// data of an entry: the score's bits, the depth, the generation and a bit telling
+// the entry is used (so an empty entry never matches the key 0)
+#define ENTRY_DEPTH_SHIFT 32
+#define ENTRY_GENERATION_SHIFT 40
+#define ENTRY_GENERATION_MASK 0x7fffff
+#define ENTRY_USED ((uint64_t)1 << 63)
+
+void ttable_init(TTable *table, size_t bytes) {
+    *table = (TTable){0};
+
+    size_t buckets = bytes / sizeof(TTableBucket);
+    if(buckets == 0) return;
+
+    // the biggest power of two that fits so the bucket is found with a mask
+    while(buckets & (buckets - 1)) buckets &= buckets - 1;
+
+    // aligned so every bucket is in a single cache line
+    table->buckets = aligned_alloc(sizeof(TTableBucket), buckets * sizeof(TTableBucket));
+    assert(table->buckets != NULL && "Not enough memory");
+    memset(table->buckets, 0, buckets * sizeof(TTableBucket));
+    table->mask = buckets - 1;
+}
+
+void ttable_free(TTable *table) {
+    free(table->buckets);
+}
+
+void ttable_new_search(TTable *table) {
+    unsigned generation = atomic_fetch_add_explicit(&table->generation, 1, memory_order_relaxed) + 1;
+
+    // the entries only keep the low bits of the generation, when they wrap the old
+    // entries would look like the current search's again so they're dropped
+    if((generation & ENTRY_GENERATION_MASK) == 0 && table->buckets != NULL) {
+        memset(table->buckets, 0, (table->mask + 1) * sizeof(TTableBucket));
+    }
+}
+
+static uint64_t pack_entry(float score, int depth, unsigned generation) {
+    uint32_t scoreBits;
+    memcpy(&scoreBits, &score, sizeof(scoreBits));
+
+    if(depth < 0) depth = 0;
+    if(depth > 0xff) depth = 0xff;
+
+    return scoreBits
+        | (uint64_t)depth << ENTRY_DEPTH_SHIFT
+        | (uint64_t)(generation & ENTRY_GENERATION_MASK) << ENTRY_GENERATION_SHIFT
+        | ENTRY_USED;
+}
+
+static int entry_depth(uint64_t data) {
+    return (data >> ENTRY_DEPTH_SHIFT) & 0xff;
+}
+
+static unsigned entry_generation(uint64_t data) {
+    return (data >> ENTRY_GENERATION_SHIFT) & ENTRY_GENERATION_MASK;
+}
+
+static TTableBucket *get_bucket(TTable *table, uint64_t key) {
+    // the low bits of the key pick the bucket, zobrist keys are random in every bit
+    return &table->buckets[key & table->mask];
+}
+
+bool ttable_probe(TTable *table, uint64_t key, TTableHit *hit) {
+    if(table->buckets == NULL) return false;
+
+    atomic_fetch_add_explicit(&table->probes, 1, memory_order_relaxed);
+    TTableBucket *bucket = get_bucket(table, key);
+    unsigned generation = atomic_load_explicit(&table->generation, memory_order_relaxed) & ENTRY_GENERATION_MASK;
+
+    for(int i = 0; i < TTABLE_BUCKET_SIZE; i++) {
+        uint64_t data = atomic_load_explicit(&bucket->entries[i].data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&bucket->entries[i].check, memory_order_relaxed);
+        if(!(data & ENTRY_USED) || (check ^ data) != key) continue;
+
+        uint32_t scoreBits = (uint32_t)data;
+        memcpy(&hit->score, &scoreBits, sizeof(hit->score));
+        hit->depth = entry_depth(data);
+        hit->currentSearch = entry_generation(data) == generation;
+
+        atomic_fetch_add_explicit(&table->hits, 1, memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+static void write_entry(TTableEntry *entry, uint64_t key, uint64_t data) {
+    atomic_store_explicit(&entry->data, data, memory_order_relaxed);
+    atomic_store_explicit(&entry->check, key ^ data, memory_order_relaxed);
+}
+
+void ttable_store(TTable *table, uint64_t key, float score, int depth) {
+    if(table->buckets == NULL) return;
+
+    atomic_fetch_add_explicit(&table->stores, 1, memory_order_relaxed);
+    TTableBucket *bucket = get_bucket(table, key);
+    unsigned generation = atomic_load_explicit(&table->generation, memory_order_relaxed) & ENTRY_GENERATION_MASK;
+    uint64_t newData = pack_entry(score, depth, generation);
+
+    // the board may already be there, otherwise the least valuable entry is the victim
+    int victim = -1;
+    int victimValue = 0;
+
+    for(int i = 0; i < TTABLE_BUCKET_SIZE; i++) {
+        TTableEntry *entry = &bucket->entries[i];
+        uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+
+        if(!(data & ENTRY_USED)) {
+            write_entry(entry, key, newData);
+            return;
+        }
+
+        if((check ^ data) == key) {
+            // a deeper entry of the current search is worth more than this one
+            if(entry_generation(data) == generation && entry_depth(data) > depth) return;
+            write_entry(entry, key, newData);
+            return;
+        }
+
+        // entries of older searches are always worth less than the current ones
+        int value = entry_depth(data) + (entry_generation(data) == generation ? 0x100 : 0);
+        if(victim < 0 || value < victimValue) {
+            victim = i;
+            victimValue = value;
+        }
+    }
+
+    if(victimValue > depth + 0x100) {
+        atomic_fetch_add_explicit(&table->rejected, 1, memory_order_relaxed);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&table->evictions, 1, memory_order_relaxed);
+    write_entry(&bucket->entries[victim], key, newData);
+}
+
+void ttable_stats(TTable *table, TTableStats *stats) {
+    stats->probes = atomic_load(&table->probes);
+    stats->hits = atomic_load(&table->hits);
+    stats->stores = atomic_load(&table->stores);
+    stats->evictions = atomic_load(&table->evictions);
+    stats->rejected = atomic_load(&table->rejected);
+}
@@ -0,0 +1,69 @@
+#ifndef TTABLE_H
+#define TTABLE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// entries sharing a bucket, a bucket is 64 bytes so it fits in a cache line
+#define TTABLE_BUCKET_SIZE 4
+
+// the entry is written without locks, so "check" is the key xor'ed with the data.
+// A reader that gets half of a write (or two writes mixed) sees a wrong key and
+// takes it as a miss instead of reading a broken entry
+typedef struct {
+    atomic_uint_fast64_t check;
+    atomic_uint_fast64_t data;
+} TTableEntry;
+
+typedef struct {
+    TTableEntry entries[TTABLE_BUCKET_SIZE];
+} TTableBucket;
+
+typedef struct {
+    float score;
+    int depth;
+    bool currentSearch; // stored after the last ttable_new_search
+} TTableHit;
+
+typedef struct {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+    uint64_t evictions; // stores that replaced an entry of another board
+    uint64_t rejected;  // stores dropped since every entry of the bucket was deeper
+} TTableStats;
+
+// fixed size hash table of board scores keyed by a hash of the board, shared
+// between threads without locks. When a bucket is full the entry with the lowest
+// depth is replaced (replace-by-depth), entries of older searches go first
+typedef struct {
+    TTableBucket *buckets;
+    uint64_t mask; // buckets - 1, the number of buckets is a power of two
+    atomic_uint generation;
+
+    // relaxed counters, they're only read to size the table
+    atomic_uint_fast64_t probes;
+    atomic_uint_fast64_t hits;
+    atomic_uint_fast64_t stores;
+    atomic_uint_fast64_t evictions;
+    atomic_uint_fast64_t rejected;
+} TTable;
+
+// the table uses at most the given bytes (rounded down to a power of two buckets),
+// with 0 bytes the table is disabled: nothing is stored and every probe misses
+void ttable_init(TTable *table, size_t bytes);
+void ttable_free(TTable *table);
+
+// entries stored before this call stop being currentSearch and are replaced first.
+// Not thread safe, the searches using the table have to be done
+void ttable_new_search(TTable *table);
+
+bool ttable_probe(TTable *table, uint64_t key, TTableHit *hit);
+// depth is how valuable the entry is, deeper entries are kept over shallower ones
+void ttable_store(TTable *table, uint64_t key, float score, int depth);
+
+void ttable_stats(TTable *table, TTableStats *stats);
+
+#endif // TTABLE_H
@@ -0,0 +1,422 @@
+// tune: evolves the weights of the beam bot's evaluation
+//
+// every generation each individual of the population plays the same games (the
+// seeds only depend on the generation) and the blocks it clears are its fitness.
+// The games run on every core, the evolution runs on the main thread after all of
+// them finish, so a run with the same seed gives the same weights whatever the
+// number of workers. The population is saved after every generation so a run can
+// be resumed
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bot.h"
+#include "eval.h"
+#include "threadpool.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+#define TUNE_DEFAULT_POPULATION 16
+#define TUNE_DEFAULT_GAMES 8
+#define TUNE_DEFAULT_GENERATIONS 10
+#define TUNE_DEFAULT_TICKS 3600
+// there are no new blocks so a game is over once the bot can't clear anything else
+#define TUNE_STALL_TICKS 300
+
+// the best individuals go to the next generation as they are
+#define TUNE_ELITES 2
+#define TUNE_TOURNAMENT_SIZE 3
+// chance of mutating every weight of a child and the size of the mutation,
+// relative to the weight so the small weights can still change
+#define TUNE_MUTATION_RATE 0.3
+#define TUNE_MUTATION_SIZE 0.25
+
+typedef struct {
+    BeamBotConfig botConfig;
+    int games;
+    int ticks;
+    uint64_t seed;
+
+    int generation;
+    uint64_t rng; // of the evolution, saved with the population
+    EvalWeights *population;
+    int populationSize;
+} Tuner;
+
+typedef struct {
+    Tuner *tuner;
+    int individual;
+    uint64_t seed;
+
+    // results of the game
+    uint32_t cleared;
+    uint64_t simulatedTicks; // of the game and of the bot's search
+} GameTask;
+
+static double random_unit(uint64_t *rng) {
+    return (splitmix64_next(rng) >> 11) * 0x1p-53;
+}
+
+// Box-Muller, the second number isn't used so it doesn't need to be kept
+static double random_gaussian(uint64_t *rng) {
+    double u = 1 - random_unit(rng);
+    double v = random_unit(rng);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static void mutate(uint64_t *rng, EvalWeights *weights, double rate) {
+    for(int i = 0; i < EVAL_NUM_OF_FEATURES; i++) {
+        if(random_unit(rng) >= rate) continue;
+        float *weight = &weights->weights[i];
+        *weight += random_gaussian(rng) * TUNE_MUTATION_SIZE * (fabsf(*weight) + 0.1f);
+    }
+}
+
+static void play_game(void *arg, int worker) {
+    (void)worker;
+    GameTask *task = arg;
+    Tuner *tuner = task->tuner;
+
+    // a new bot every game, the transposition table of a previous game could change its decisions
+    BeamBotConfig config = tuner->botConfig;
+    config.weights = tuner->population[task->individual];
+    BeamBot bot;
+    beam_bot_init(&bot, config);
+
+    Panel panel = {0};
+    panel_init(&panel, task->seed);
+
+    int tick = 0;
+    int lastClearTick = 0;
+    for(; tick < tuner->ticks && tick - lastClearTick < TUNE_STALL_TICKS; tick++) {
+        uint32_t cleared = panel.clearedBlocks;
+
+        panel_apply_input(&panel, beam_bot_input(&bot, &panel));
+        panel_update(&panel);
+
+        if(panel.clearedBlocks != cleared || panel.combos.count > 0) lastClearTick = tick;
+    }
+
+    task->cleared = panel.clearedBlocks;
+    task->simulatedTicks = tick + bot.stats.simulatedTicks;
+    beam_bot_free(&bot);
+}
+
+// the seed of a game only depends on the run's seed, the generation and the game
+static uint64_t game_seed(Tuner *tuner, int game) {
+    uint64_t state = tuner->seed ^ ((uint64_t)tuner->generation << 32 | (uint64_t)game);
+    return splitmix64_next(&state);
+}
+
+// the index of the best of a few random individuals
+static int tournament(Tuner *tuner, const uint64_t *fitness) {
+    int best = splitmix64_next(&tuner->rng) % tuner->populationSize;
+    for(int i = 1; i < TUNE_TOURNAMENT_SIZE; i++) {
+        int other = splitmix64_next(&tuner->rng) % tuner->populationSize;
+        if(fitness[other] > fitness[best]) best = other;
+    }
+    return best;
+}
+
+// replaces the population with the next generation, order has the individuals from best to worst
+static void evolve(Tuner *tuner, const uint64_t *fitness, const int *order) {
+    EvalWeights *next = malloc(sizeof(EvalWeights) * tuner->populationSize);
+    assert(next != NULL && "Not enough memory");
+
+    for(int i = 0; i < tuner->populationSize; i++) {
+        if(i < TUNE_ELITES) {
+            next[i] = tuner->population[order[i]];
+            continue;
+        }
+
+        // uniform crossover, every weight comes from one of the parents
+        EvalWeights *a = &tuner->population[tournament(tuner, fitness)];
+        EvalWeights *b = &tuner->population[tournament(tuner, fitness)];
+        for(int j = 0; j < EVAL_NUM_OF_FEATURES; j++) {
+            next[i].weights[j] = splitmix64_next(&tuner->rng) & 1 ? a->weights[j] : b->weights[j];
+        }
+        mutate(&tuner->rng, &next[i], TUNE_MUTATION_RATE);
+    }
+
+    free(tuner->population);
+    tuner->population = next;
+    tuner->generation++;
+}
+
+// the checkpoint is text: the state of the run, the settings that change the
+// fitness and then a line per individual with its weights in the order of the
+// "features" line
+static bool save_checkpoint(Tuner *tuner, const char *path) {
+    // written to another file first so a crash doesn't leave a half written checkpoint
+    char tmpPath[1024];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+    FILE *f = fopen(tmpPath, "w");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", tmpPath);
+        return false;
+    }
+
+    fprintf(f, "generation %d\n", tuner->generation);
+    fprintf(f, "seed %llu\n", (unsigned long long)tuner->seed);
+    fprintf(f, "rng %llu\n", (unsigned long long)tuner->rng);
+    fprintf(f, "population %d\n", tuner->populationSize);
+    fprintf(f, "games %d\n", tuner->games);
+    fprintf(f, "ticks %d\n", tuner->ticks);
+    fprintf(f, "width %d\n", tuner->botConfig.beamWidth);
+    fprintf(f, "depth %d\n", tuner->botConfig.depth);
+    fprintf(f, "features");
+    for(int i = 0; i < EVAL_NUM_OF_FEATURES; i++) fprintf(f, " %s", EVAL_FEATURE_NAMES[i]);
+    fprintf(f, "\n");
+
+    for(int i = 0; i < tuner->populationSize; i++) {
+        for(int j = 0; j < EVAL_NUM_OF_FEATURES; j++) {
+            fprintf(f, j == 0 ? "%.9g" : " %.9g", tuner->population[i].weights[j]);
+        }
+        fprintf(f, "\n");
+    }
+
+    bool ok = !ferror(f);
+    if(fclose(f) != 0) ok = false;
+    if(ok && rename(tmpPath, path) != 0) {
+        log_error("Couldn't replace \"%s\"", path);
+        ok = false;
+    }
+    return ok;
+}
+
+static bool load_checkpoint(Tuner *tuner, const char *path) {
+    FILE *f = fopen(path, "r");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    unsigned long long seed, rng;
+    bool ok = fscanf(f, " generation %d seed %llu rng %llu population %d games %d ticks %d width %d depth %d features",
+        &tuner->generation, &seed, &rng, &tuner->populationSize, &tuner->games, &tuner->ticks,
+        &tuner->botConfig.beamWidth, &tuner->botConfig.depth) == 8;
+    ok = ok && tuner->populationSize > TUNE_ELITES && tuner->games > 0 && tuner->ticks > 0
+        && tuner->botConfig.beamWidth > 0 && tuner->botConfig.depth > 0;
+    tuner->seed = seed;
+    tuner->rng = rng;
+
+    // the features have to be the same ones, in the same order
+    for(int i = 0; ok && i < EVAL_NUM_OF_FEATURES; i++) {
+        char name[64];
+        ok = fscanf(f, "%63s", name) == 1 && strcmp(name, EVAL_FEATURE_NAMES[i]) == 0;
+    }
+
+    if(ok) {
+        tuner->population = malloc(sizeof(EvalWeights) * tuner->populationSize);
+        assert(tuner->population != NULL && "Not enough memory");
+    }
+
+    for(int i = 0; ok && i < tuner->populationSize; i++) {
+        for(int j = 0; ok && j < EVAL_NUM_OF_FEATURES; j++) {
+            ok = fscanf(f, "%f", &tuner->population[i].weights[j]) == 1;
+        }
+    }
+
+    if(!ok) log_error("\"%s\" isn't a checkpoint of this build", path);
+    fclose(f);
+    return ok;
+}
+
+static bool save_weights(const EvalWeights *weights, const char *path) {
+    FILE *f = fopen(path, "w");
+    if(f == NULL) {
+        log_error("Couldn't open \"%s\"", path);
+        return false;
+    }
+
+    fprintf(f, "# tuned weights of the beam bot\n");
+    eval_weights_write(f, weights);
+
+    bool ok = !ferror(f);
+    if(fclose(f) != 0) ok = false;
+    return ok;
+}
+
+// the individuals from best to worst, ties go to the lowest index so the order is always the same
+static void sort_by_fitness(int *order, const uint64_t *fitness, int count) {
+    for(int i = 0; i < count; i++) order[i] = i;
+
+    for(int i = 1; i < count; i++) {
+        int index = order[i];
+        int j = i;
+        while(j > 0 && fitness[order[j - 1]] < fitness[index]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = index;
+    }
+}
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --generations <n>   generations to run (default %d)\n", TUNE_DEFAULT_GENERATIONS);
+    printf("  --population <n>    individuals of every generation (default %d)\n", TUNE_DEFAULT_POPULATION);
+    printf("  --games <n>         games every individual plays per generation (default %d)\n", TUNE_DEFAULT_GAMES);
+    printf("  --ticks <n>         max ticks of a game (default %d)\n", TUNE_DEFAULT_TICKS);
+    printf("  --seed <n>          seed of the games and of the evolution\n");
+    printf("  --threads <n>       workers playing the games (default every core)\n");
+    printf("  --width <n>         beam width of the bots\n");
+    printf("  --depth <n>         swaps the bots search ahead\n");
+    printf("  --weights <file>    weights of the first individual, the rest are mutations of it\n");
+    printf("  --checkpoint <file> saves the population after every generation\n");
+    printf("  --resume <file>     continues from a checkpoint, with its population, games, ticks, width and depth\n");
+    printf("  --out <file>        writes the best weights after every generation\n");
+}
+
+int main(int argc, char **argv) {
+    Tuner tuner = {
+        .botConfig = BEAM_BOT_DEFAULT_CONFIG,
+        .games = TUNE_DEFAULT_GAMES,
+        .ticks = TUNE_DEFAULT_TICKS,
+        .seed = 1,
+        .populationSize = TUNE_DEFAULT_POPULATION,
+    };
+    // the whole search runs every time, a time budget would depend on the machine
+    tuner.botConfig.timeBudget = 0;
+
+    int generations = TUNE_DEFAULT_GENERATIONS;
+    int threads = 0;
+    EvalWeights initial = EVAL_DEFAULT_WEIGHTS;
+    const char *checkpointPath = NULL;
+    const char *resumePath = NULL;
+    const char *outPath = NULL;
+    // the settings given on the command line, a resumed run takes them from the checkpoint
+    Tuner given = {0};
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--generations") == 0 && hasValue) {
+            generations = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--population") == 0 && hasValue) {
+            tuner.populationSize = given.populationSize = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--games") == 0 && hasValue) {
+            tuner.games = given.games = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            tuner.ticks = given.ticks = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--seed") == 0 && hasValue) {
+            tuner.seed = strtoull(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--width") == 0 && hasValue) {
+            tuner.botConfig.beamWidth = given.botConfig.beamWidth = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--depth") == 0 && hasValue) {
+            tuner.botConfig.depth = given.botConfig.depth = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--weights") == 0 && hasValue) {
+            if(!eval_weights_load(&initial, argv[++i])) return 1;
+        } else if(strcmp(argv[i], "--checkpoint") == 0 && hasValue) {
+            checkpointPath = argv[++i];
+        } else if(strcmp(argv[i], "--resume") == 0 && hasValue) {
+            resumePath = argv[++i];
+        } else if(strcmp(argv[i], "--out") == 0 && hasValue) {
+            outPath = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(resumePath != NULL) {
+        if(!load_checkpoint(&tuner, resumePath)) return 1;
+
+        bool otherSettings = (given.populationSize != 0 && given.populationSize != tuner.populationSize)
+            || (given.games != 0 && given.games != tuner.games)
+            || (given.ticks != 0 && given.ticks != tuner.ticks)
+            || (given.botConfig.beamWidth != 0 && given.botConfig.beamWidth != tuner.botConfig.beamWidth)
+            || (given.botConfig.depth != 0 && given.botConfig.depth != tuner.botConfig.depth);
+        if(otherSettings) {
+            log_error("\"%s\" was made with other settings, they can't change when resuming", resumePath);
+            return 1;
+        }
+    } else {
+        if(tuner.populationSize <= TUNE_ELITES || tuner.games <= 0) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        // the first individual is the initial weights as they are
+        tuner.rng = tuner.seed;
+        tuner.population = malloc(sizeof(EvalWeights) * tuner.populationSize);
+        assert(tuner.population != NULL && "Not enough memory");
+
+        for(int i = 0; i < tuner.populationSize; i++) {
+            tuner.population[i] = initial;
+            if(i > 0) mutate(&tuner.rng, &tuner.population[i], 1);
+        }
+    }
+
+    zobrist_init();
+
+    ThreadPool *pool = threadpool_create(threads);
+    int numTasks = tuner.populationSize * tuner.games;
+    GameTask *tasks = malloc(sizeof(GameTask) * numTasks);
+    uint64_t *fitness = malloc(sizeof(uint64_t) * tuner.populationSize);
+    int *order = malloc(sizeof(int) * tuner.populationSize);
+    assert(tasks != NULL && fitness != NULL && order != NULL && "Not enough memory");
+
+    printf("%d individuals, %d games of %d ticks each, %d workers\n",
+        tuner.populationSize, tuner.games, tuner.ticks, pool->numWorkers);
+
+    double runStart = now_seconds();
+    uint64_t runTicks = 0;
+    int lastGeneration = tuner.generation + generations;
+
+    while(tuner.generation < lastGeneration) {
+        double start = now_seconds();
+
+        for(int i = 0; i < numTasks; i++) {
+            tasks[i] = (GameTask){
+                .tuner = &tuner,
+                .individual = i / tuner.games,
+                .seed = game_seed(&tuner, i % tuner.games),
+            };
+            threadpool_submit(pool, play_game, &tasks[i]);
+        }
+        threadpool_wait(pool);
+
+        double elapsed = now_seconds() - start;
+        uint64_t ticks = 0;
+        memset(fitness, 0, sizeof(uint64_t) * tuner.populationSize);
+        for(int i = 0; i < numTasks; i++) {
+            fitness[tasks[i].individual] += tasks[i].cleared;
+            ticks += tasks[i].simulatedTicks;
+        }
+        runTicks += ticks;
+
+        sort_by_fitness(order, fitness, tuner.populationSize);
+
+        uint64_t total = 0;
+        for(int i = 0; i < tuner.populationSize; i++) total += fitness[i];
+
+        printf("generation %d: best %.1f, mean %.1f blocks per game, %.1fs (%.0f games/s, %.0f simulated ticks/s)\n",
+            tuner.generation, (double)fitness[order[0]] / tuner.games,
+            (double)total / numTasks, elapsed, numTasks / elapsed, ticks / elapsed);
+
+        if(outPath != NULL && !save_weights(&tuner.population[order[0]], outPath)) return 1;
+
+        evolve(&tuner, fitness, order);
+        if(checkpointPath != NULL && !save_checkpoint(&tuner, checkpointPath)) return 1;
+    }
+
+    double elapsed = now_seconds() - runStart;
+    printf("%d generations in %.1fs, %.0f simulated ticks/s (%.0f per worker)\n", generations, elapsed,
+        runTicks / elapsed, runTicks / elapsed / pool->numWorkers);
+
+    // the elites are the first individuals of the new population, the best one first
+    printf("best weights:\n");
+    eval_weights_write(stdout, &tuner.population[0]);
+
+    threadpool_destroy(pool);
+    free(tasks);
+    free(fitness);
+    free(order);
+    free(tuner.population);
+    return 0;
+}
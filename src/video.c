@@ -0,0 +1,257 @@
+// video: turns a replay into an uncompressed video, without a GPU or a window
+//
+// the replay is simulated as fast as possible and every tick is a frame drawn by
+// the CPU rasterizer. The simulation is sequential but it's cheap, so the frames
+// are recorded in batches and every worker rasterizes and converts whole frames
+// with its own raster, then they are written in order. The output is a Y4M stream
+// (4:2:0, what most tools expect) or a sequence of PPM images, e.g.
+//   ./video replay.tarp | ffmpeg -i - out.mp4
+//   ./video --ppm replay.tarp | ffmpeg -f image2pipe -c:v ppm -framerate 60 -i - out.mp4
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "raster.h"
+#include "replay.h"
+#include "timer.h"
+#include "CCFuncs.h"
+
+#define BLOCKS_SPRITESHEET_FILE "./assets/blocks.png"
+#define BLOCKS_ATLAS_FILE "./assets/blocks.atlas"
+#define VIDEO_FPS 60
+// frames recorded per worker before waiting for them, enough to keep them busy
+#define VIDEO_FRAMES_PER_WORKER 4
+
+typedef enum {
+    VIDEO_Y4M,
+    VIDEO_PPM,
+} VideoFormat;
+
+typedef struct {
+    RenderList list;
+    uint8_t *data; // the encoded frame, ready to be written
+    size_t size;
+} VideoFrame;
+
+typedef struct {
+    VideoFormat format;
+    int width, height;
+    Raster **rasters; // one per worker, each one draws on its own thread
+    VideoFrame *frames;
+} Video;
+
+typedef struct {
+    Video *video;
+    VideoFrame *frame;
+} VideoTask;
+
+// BT.601 with the limited range, what a Y4M without a color range is
+static inline uint8_t rgb_to_y(int r, int g, int b) {
+    return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+}
+
+static inline uint8_t rgb_to_u(int r, int g, int b) {
+    return ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+}
+
+static inline uint8_t rgb_to_v(int r, int g, int b) {
+    return ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+static size_t encode_y4m(VideoFrame *frame, const Color *pixels, int width, int height) {
+    static const char header[] = "FRAME\n";
+    uint8_t *y = frame->data;
+    memcpy(y, header, sizeof(header) - 1);
+    y += sizeof(header) - 1;
+    uint8_t *u = y + width * height;
+    uint8_t *v = u + width / 2 * height / 2;
+
+    for(int i = 0; i < width * height; i++) {
+        y[i] = rgb_to_y(pixels[i].r, pixels[i].g, pixels[i].b);
+    }
+
+    // the chroma is the average of every 2x2 block
+    for(int row = 0; row < height / 2; row++) {
+        for(int col = 0; col < width / 2; col++) {
+            const Color *p = &pixels[row * 2 * width + col * 2];
+            const Color *q = p + width;
+            int r = (p[0].r + p[1].r + q[0].r + q[1].r + 2) / 4;
+            int g = (p[0].g + p[1].g + q[0].g + q[1].g + 2) / 4;
+            int b = (p[0].b + p[1].b + q[0].b + q[1].b + 2) / 4;
+            *u++ = rgb_to_u(r, g, b);
+            *v++ = rgb_to_v(r, g, b);
+        }
+    }
+
+    return v - frame->data;
+}
+
+static size_t encode_ppm(VideoFrame *frame, const Color *pixels, int width, int height) {
+    int headerSize = sprintf((char *)frame->data, "P6\n%d %d\n255\n", width, height);
+    uint8_t *out = frame->data + headerSize;
+
+    for(int i = 0; i < width * height; i++) {
+        *out++ = pixels[i].r;
+        *out++ = pixels[i].g;
+        *out++ = pixels[i].b;
+    }
+
+    return out - frame->data;
+}
+
+static size_t encoded_size(VideoFormat format, int width, int height) {
+    // the PPM header is at most 32 bytes
+    if(format == VIDEO_PPM) return 32 + (size_t)width * height * 3;
+    return strlen("FRAME\n") + (size_t)width * height * 3 / 2;
+}
+
+static void draw_frame(void *arg, int worker) {
+    VideoTask *task = arg;
+    Video *video = task->video;
+    VideoFrame *frame = task->frame;
+    Raster *raster = video->rasters[worker];
+
+    raster_draw(raster, &frame->list, BLACK);
+    if(video->format == VIDEO_Y4M) {
+        frame->size = encode_y4m(frame, raster->pixels, video->width, video->height);
+    } else {
+        frame->size = encode_ppm(frame, raster->pixels, video->width, video->height);
+    }
+}
+
+void print_usage(const char *program) {
+    printf("Usage: %s [options] <replay>\n", program);
+    printf("  --out <file>     where the video goes (default stdout)\n");
+    printf("  --ppm            a sequence of PPM images instead of Y4M\n");
+    printf("  --size <w>x<h>   size of the frames, even for Y4M (default 1280x720)\n");
+    printf("  --ticks <n>      frames of the video (default the length of the replay)\n");
+    printf("  --threads <n>    workers drawing the frames (default every core)\n");
+}
+
+int main(int argc, char **argv) {
+    const char *outPath = NULL;
+    VideoFormat format = VIDEO_Y4M;
+    int width = 1280;
+    int height = 720;
+    int ticks = -1;
+    int threads = 0;
+    const char *replayPath = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--out") == 0 && hasValue) {
+            outPath = argv[++i];
+        } else if(strcmp(argv[i], "--ppm") == 0) {
+            format = VIDEO_PPM;
+        } else if(strcmp(argv[i], "--size") == 0 && hasValue) {
+            if(sscanf(argv[++i], "%dx%d", &width, &height) != 2) width = 0;
+        } else if(strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            ticks = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if(argv[i][0] != '-' && replayPath == NULL) {
+            replayPath = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    bool validSize = width > 0 && height > 0 && (format == VIDEO_PPM || (width % 2 == 0 && height % 2 == 0));
+    if(replayPath == NULL || !validSize) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    Replay replay = {0};
+    if(!replay_load(&replay, replayPath)) return 1;
+    if(ticks < 0) ticks = replay.count;
+
+    FILE *out = stdout;
+    if(outPath != NULL) {
+        out = fopen(outPath, "wb");
+        if(out == NULL) {
+            log_error("Couldn't open \"%s\"", outPath);
+            return 1;
+        }
+    }
+
+    SpriteSheet sheet;
+    if(!sprite_sheet_load(&sheet, BLOCKS_SPRITESHEET_FILE, BLOCKS_ATLAS_FILE)) return 1;
+
+    // the frames are split between the workers, every raster draws on a single thread
+    ThreadPool *pool = threadpool_create(threads);
+    int numFrames = pool->numWorkers * VIDEO_FRAMES_PER_WORKER;
+
+    Video video = { .format = format, .width = width, .height = height };
+    video.rasters = malloc(sizeof(Raster *) * pool->numWorkers);
+    video.frames = calloc(numFrames, sizeof(VideoFrame));
+    VideoTask *tasks = malloc(sizeof(VideoTask) * numFrames);
+    assert(video.rasters != NULL && video.frames != NULL && tasks != NULL && "Not enough memory");
+
+    for(int i = 0; i < pool->numWorkers; i++) {
+        video.rasters[i] = raster_create(width, height, &sheet, 1);
+    }
+    for(int i = 0; i < numFrames; i++) {
+        video.frames[i].data = malloc(encoded_size(format, width, height));
+        assert(video.frames[i].data != NULL && "Not enough memory");
+        tasks[i] = (VideoTask){ .video = &video, .frame = &video.frames[i] };
+    }
+
+    if(format == VIDEO_Y4M) {
+        fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, VIDEO_FPS);
+    }
+
+    zobrist_init();
+    Panel panel = {0};
+    panel_init(&panel, replay.seed);
+    layout_panel(&panel, height);
+
+    double start = now_seconds();
+    bool ok = true;
+
+    for(int tick = 0; tick < ticks && ok;) {
+        int batch = MIN(numFrames, ticks - tick);
+
+        for(int i = 0; i < batch; i++, tick++) {
+            // once the replay ends the panel just keeps going without input
+            uint8_t input = (size_t)tick < replay.count ? replay.items[tick] : 0;
+            panel_apply_input(&panel, input);
+            panel_update(&panel);
+
+            render_list_clear(&video.frames[i].list);
+            render_list_panel(&video.frames[i].list, &panel, true);
+            threadpool_submit(pool, draw_frame, &tasks[i]);
+        }
+        threadpool_wait(pool);
+
+        for(int i = 0; i < batch && ok; i++) {
+            ok = fwrite(video.frames[i].data, 1, video.frames[i].size, out) == video.frames[i].size;
+        }
+    }
+
+    double elapsed = now_seconds() - start;
+    if(!ok) {
+        log_error("Couldn't write \"%s\"", outPath != NULL ? outPath : "the video");
+    } else {
+        fprintf(stderr, "%d frames in %.2fs, %.1fx real time\n", ticks, elapsed,
+            (double)ticks / VIDEO_FPS / elapsed);
+    }
+
+    if(out != stdout) fclose(out);
+    for(int i = 0; i < pool->numWorkers; i++) raster_destroy(video.rasters[i]);
+    for(int i = 0; i < numFrames; i++) {
+        render_list_free(&video.frames[i].list);
+        free(video.frames[i].data);
+    }
+    free(video.rasters);
+    free(video.frames);
+    free(tasks);
+    threadpool_destroy(pool);
+    sprite_sheet_unload(&sheet);
+    replay_free(&replay);
+    return ok ? 0 : 1;
+}